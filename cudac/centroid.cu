@@ -29,12 +29,10 @@ uint3 dimGrid = { 1, 1, 1 };
 uint numCentroids;
 uint szCentroidList, szUnpackedArray;
 
-float *d_centroidList;
+float *d_centroidX, *d_centroidY, *d_centroidZ; ///< Centroids (SoA, coalesced reads)
 
 uint *d_unpackedArray;
 
-texture<float4, 1, cudaReadModeElementType> centroidTex;
-
 //Round a / b to nearest higher integer value
 __host__ inline uint
 iDivUp(uint a, uint b) { return (a % b != 0) ? (a / b + 1) : (a / b); }
@@ -47,6 +45,7 @@ iAlignUp(uint a, uint b) { return (a % b != 0) ? (a - a % b + b) : a; }
 
 __global__
 void updateCentroid( uint_64 *packedArray,
+		     const float *centroidX, const float *centroidY, const float *centroidZ,
 		     const float mvX, const float mvY, const float mvZ,
 		     const uint nC ) {
 
@@ -55,9 +54,7 @@ void updateCentroid( uint_64 *packedArray,
 
 	if( centroidId >= nC ) centroidId = nC - 1;
 
- 	float4 centroid = tex1Dfetch(centroidTex, centroidId );
-
-	float cZ = mvX * centroid.x + mvY * centroid.y + mvZ * centroid.z;
+	float cZ = mvX * centroidX[ centroidId ] + mvY * centroidY[ centroidId ] + mvZ * centroidZ[ centroidId ];
 
 	if( cZ < -1.0 ) cZ = -1.0;
 	if( cZ >  1.0 ) cZ =  1.0;
@@ -87,23 +84,42 @@ void unpackArray( uint *unpackedArray,
 
 }
 
+/// Number of devices (0 without a device or driver)
+
+//extern "C"
+__host__
+int numDevicesCUDA( void ) {
+
+	int count = 0;
+
+	if( cudaGetDeviceCount( &count ) != cudaSuccess ) return 0;
+
+	return count;
+
+}
+
 /// Initialize General
 
 //extern "C"
 __host__
-void initCUDA( float *h_centroidList, uint _numCentroids ) {
+void initCUDA( const float *h_centroidX, const float *h_centroidY,
+	       const float *h_centroidZ, uint _numCentroids ) {
 
 	/// General
 	numCentroids = _numCentroids;
 
-	szCentroidList = numCentroids * 4 * sizeof(float);
+	szCentroidList = numCentroids * sizeof(float); ///< Size of each SoA array
 
 	szUnpackedArray = numCentroids * sizeof(uint);
 
 	dimGrid.x = iDivUp( numCentroids, NTHREADS );
 
-	CUDA_SAFE_CALL( cudaMalloc((void**) &d_centroidList, szCentroidList) );
- 	CUDA_SAFE_CALL( cudaMemcpy(d_centroidList, h_centroidList, szCentroidList, cudaMemcpyHostToDevice) );
+	CUDA_SAFE_CALL( cudaMalloc((void**) &d_centroidX, szCentroidList) );
+	CUDA_SAFE_CALL( cudaMalloc((void**) &d_centroidY, szCentroidList) );
+	CUDA_SAFE_CALL( cudaMalloc((void**) &d_centroidZ, szCentroidList) );
+ 	CUDA_SAFE_CALL( cudaMemcpy(d_centroidX, h_centroidX, szCentroidList, cudaMemcpyHostToDevice) );
+ 	CUDA_SAFE_CALL( cudaMemcpy(d_centroidY, h_centroidY, szCentroidList, cudaMemcpyHostToDevice) );
+ 	CUDA_SAFE_CALL( cudaMemcpy(d_centroidZ, h_centroidZ, szCentroidList, cudaMemcpyHostToDevice) );
 
 	CUDA_SAFE_CALL( cudaMalloc((void**) &d_unpackedArray, szUnpackedArray) );
 
@@ -119,11 +135,8 @@ void initCUDA( float *h_centroidList, uint _numCentroids ) {
 __host__
 void bitonicSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
 
-	CUDA_SAFE_CALL( cudaBindTexture(0, centroidTex, d_centroidList, szCentroidList) );
-
-	updateCentroid<<< dimGrid, dimBlock >>>( d_packedArrayBitonic, _mvX, _mvY, _mvZ, numCentroids );
-
-	CUDA_SAFE_CALL( cudaUnbindTexture(centroidTex) );
+	updateCentroid<<< dimGrid, dimBlock >>>( d_packedArrayBitonic, d_centroidX, d_centroidY, d_centroidZ,
+						 _mvX, _mvY, _mvZ, numCentroids );
 
 	bitonicSort();
 
@@ -139,16 +152,13 @@ void bitonicSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
 __host__
 void quickSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
 
-	CUDA_SAFE_CALL( cudaBindTexture(0, centroidTex, d_centroidList, szCentroidList) );
-
 	// create and start timer
 // 	unsigned timer;
 // 	cutCreateTimer(&timer);
 // 	cutStartTimer(timer);
 
-	updateCentroid<<< dimGrid, dimBlock >>>( d_packedArrayQuick, _mvX, _mvY, _mvZ, numCentroids );
-
-	CUDA_SAFE_CALL( cudaUnbindTexture(centroidTex) );
+	updateCentroid<<< dimGrid, dimBlock >>>( d_packedArrayQuick, d_centroidX, d_centroidY, d_centroidZ,
+						 _mvX, _mvY, _mvZ, numCentroids );
 
 	quickSort();
 
@@ -163,17 +173,37 @@ void quickSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
 
 }
 
+/// Size of the device arrays
+
+//extern "C"
+__host__
+unsigned long long sizeOfCUDA( void ) {
+
+	if( !numCentroids ) return 0;
+
+	return ( 3ULL * szCentroidList + ///< Centroids copy (SoA)
+		 szUnpackedArray + ///< Sorted ids
+		 szPackedArrayBitonic + ///< Bitonic keys (power of two)
+		 2ULL * szPackedArrayQuick ///< Quick sort keys and auxiliary array
+		);
+
+}
+
 /// Clean CUDA memory
 
 //extern "C"
 __host__
 void cleanCUDA( void ) {
 
-	CUDA_SAFE_CALL( cudaFree(d_centroidList) );
+	CUDA_SAFE_CALL( cudaFree(d_centroidX) );
+	CUDA_SAFE_CALL( cudaFree(d_centroidY) );
+	CUDA_SAFE_CALL( cudaFree(d_centroidZ) );
  	CUDA_SAFE_CALL( cudaFree(d_unpackedArray) );
 
 	cleanBitonic();
 
 	cleanQuick();
 
+	numCentroids = 0;
+
 }
@@ -6,11 +6,18 @@
  */
 
 extern "C"
-void initCUDA( float *h_centroidList, unsigned _numCentroids );
+int numDevicesCUDA( void );
+
+extern "C"
+void initCUDA( const float *h_centroidX, const float *h_centroidY,
+	       const float *h_centroidZ, unsigned _numCentroids );
 
 extern "C"
 void cleanCUDA( void );
 
+extern "C"
+unsigned long long sizeOfCUDA( void );
+
 extern "C"
 void bitonicSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ );
 
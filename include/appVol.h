@@ -53,7 +53,7 @@ public:
 	string volName;
 
 	/// File extensions
-	string offExt, tfExt, lmtExt, conExt, isoExt;
+	string offExt, tfExt, lmtExt, conExt, isoExt, ordExt;
 
 	/// Searching directory for files
 	string searchDir;
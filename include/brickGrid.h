@@ -0,0 +1,89 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   brickGrid : defines a class to partition the tetrahedra in spatial
+ *               bricks (uniform grid over the centroids) and to sort them
+ *               in two levels: bricks by depth, then tets inside bricks.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _BRICKGRID_H_
+#define _BRICKGRID_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+#include "centroidStore.h"
+
+/// Bricks per axis of the grid (only non-empty bricks are kept)
+#define BRICK_RES 16
+
+/// ----------------------------------   brickGrid   ------------------------------------
+
+/// Brick Grid
+
+class brickGrid {
+
+public:
+
+	/// Constructor
+	brickGrid();
+
+	/// Destructor
+	~brickGrid();
+
+	/// Build the bricks
+	///   Tets go to the brick of their centroid, and are stored brick
+	///   by brick (counting sort), keeping the id order inside a brick
+	/// @arg c tetrahedra centroids
+	/// @arg res bricks per axis
+	/// @return true if it succeed
+	bool build(const centroidStore& c, GLuint res = BRICK_RES);
+
+	/// @return true if the bricks are built
+	bool valid(void) const { return brickTets != NULL; }
+
+	/// Size of brick grid
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// Number of (non-empty) bricks
+	GLuint size(void) const { return numBricks; }
+
+	/// Two-level back-to-front sort
+	///   Bricks are sorted by the Z of their center, giving the output
+	///   slice of each brick; then the tets of each brick are sorted by
+	///   centroid Z in parallel, straight into their slice of ids
+	/// @arg ids output sorted ids (only written)
+	/// @arg scratch centroids scratch array (numTets elements)
+	/// @arg c tetrahedra centroids
+	/// @arg mv column-major modelview matrix
+	void sort(GLuint *ids, tetCentroid *scratch, const centroidStore& c, const GLfloat *mv);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	GLuint numBricks; ///< Number of non-empty bricks
+
+	GLuint *brickStart; ///< First tet of each brick (numBricks + 1)
+
+	GLuint *brickTets; ///< Tets brick by brick
+
+	GLfloat *brickCenter; ///< Center of each brick (numBricks x 3)
+
+	tetCentroid *brickOrder; ///< Bricks sorted by depth
+
+	GLuint *brickOut; ///< Output offset of each brick
+
+};
+
+#endif
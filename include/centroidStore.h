@@ -0,0 +1,133 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   centroidStore : defines a class to store the tetrahedra centroids in
+ *                   structure-of-arrays (SoA) layout and to compute their
+ *                   depth using SIMD instructions (AVX-512, AVX2 or portable).
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _CENTROIDSTORE_H_
+#define _CENTROIDSTORE_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+#include <cmath>
+
+/// Fused multiply-add in hardware (AVX-512 always has it)
+#if defined(__FMA__) || defined(__AVX512F__)
+#define CENTROID_FMA
+#endif
+
+/// ----------------------------------   centroidStore   ------------------------------------
+
+/// Centroid Store
+
+class centroidStore {
+
+public:
+
+	/// Constructor
+	centroidStore();
+
+	/// Destructor
+	~centroidStore();
+
+	/// Build the centroid of each tetrahedron
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol);
+
+	/// Size of centroid store
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// Number of centroids
+	GLuint size(void) const { return numCentroids; }
+
+	/// Centroid coordinates
+	/// @arg i tetrahedron id
+	GLfloat x(GLuint i) const { return cX[i]; }
+	GLfloat y(GLuint i) const { return cY[i]; }
+	GLfloat z(GLuint i) const { return cZ[i]; }
+
+	/// SoA arrays (read only)
+	const GLfloat *xList(void) const { return cX; }
+	const GLfloat *yList(void) const { return cY; }
+	const GLfloat *zList(void) const { return cZ; }
+
+	/// Depth of one centroid: dot product with a matrix row
+	/// @arg i tetrahedron id
+	/// @arg mv column-major matrix (modelview)
+	/// @arg row matrix row (default z -> r=2)
+	GLfloat depth(GLuint i, const GLfloat *mv, GLuint row = 2) const {
+		return rowDot( mv + row, cX[i], cY[i], cZ[i] );
+	}
+
+	/// Depth arithmetic of every path (scalar and SIMD): nested
+	/// multiply-adds, fused if the CPU has FMA, so a centroid gets the
+	/// same depth wherever it is in the array
+	/// @arg m matrix row (every 4 floats)
+	/// @arg x, y, z centroid coordinates
+	static GLfloat rowDot(const GLfloat *m, GLfloat x, GLfloat y, GLfloat z) {
+#ifdef CENTROID_FMA
+		return fmaf( m[0], x, fmaf( m[4], y, fmaf( m[8], z, m[12] ) ) );
+#else
+		return m[0] * x + ( m[4] * y + ( m[8] * z + m[12] ) );
+#endif
+	}
+
+	/// Depths of all centroids in one streaming pass
+	/// @arg d output depths, written every stride floats
+	/// @arg mv column-major matrix (modelview)
+	/// @arg stride output stride (in floats)
+	/// @arg row matrix row (default z -> r=2)
+	void depths(GLfloat *d, const GLfloat *mv, GLuint stride = 1, GLuint row = 2) const;
+
+	/// Monotone 32-bit depth keys of all centroids in one streaming pass
+	/// @arg k output keys (see cpuSort::floatKey)
+	/// @arg mv column-major matrix (modelview)
+	/// @arg row matrix row (default z -> r=2)
+	void keys(GLuint *k, const GLfloat *mv, GLuint row = 2) const;
+
+	/// Monotone 32-bit depth keys following a given order (gather)
+	/// @arg k output keys, k[i] is the key of centroid order[i]
+	/// @arg order centroid ids
+	/// @arg n number of ids in order
+	/// @arg mv column-major matrix (modelview)
+	/// @arg row matrix row (default z -> r=2)
+	void keys(GLuint *k, const GLuint *order, GLuint n, const GLfloat *mv, GLuint row = 2) const;
+
+	/// Levels of a median split until every leaf has at most leafSize tets
+	/// @arg leafSize maximum number of tets in a leaf
+	/// @return number of levels of internal nodes
+	GLuint splitLevels(GLuint leafSize) const;
+
+	/// Balanced median split
+	///   Each node splits its tets in two halves at the median centroid
+	///   of the longest axis (heap order, children of node k are 2k+1
+	///   and 2k+2), one level at a time, the nodes of a level in parallel
+	/// @arg perm output tets in split order (each node is a contiguous range)
+	/// @arg levels number of levels of internal nodes (see splitLevels)
+	/// @arg axis output split axis of each internal node (NULL if not needed)
+	/// @arg leafStart output first tet of each leaf in perm, plus the end (NULL if not needed)
+	void medianSplit(GLuint *perm, GLuint levels, GLubyte *axis = NULL, GLuint *leafStart = NULL) const;
+
+private:
+
+	GLuint numCentroids; ///< Number of centroids
+
+	GLfloat *cX, *cY, *cZ; ///< Centroid coordinates (SoA)
+
+};
+
+#endif
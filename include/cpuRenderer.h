@@ -0,0 +1,162 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   cpuRenderer : defines a class for multithreaded CPU (software)
+ *                 rendering of the projected tetrahedra, the same
+ *                 pipeline of hapt_dvr.geom and hapt_dvr.frag without
+ *                 a geometry-shader GPU.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _CPURENDERER_H_
+#define _CPURENDERER_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+/// Screen tile size (in pixels), tiles are rasterized in parallel
+#define RENDER_TILE 64
+
+/// Tets projected and binned at once (bounds the triangles memory)
+#define RENDER_BATCH (1 << 16)
+
+/// Maximum number of triangles of a projected tet (PT class 1)
+#define MAX_TET_TRIS 4
+
+/// Sub-pixel precision of the window coordinates (exact edge functions)
+#define RENDER_SUBPIXEL 256.0
+
+/// Largest window coordinate rasterized (triangles are not clipped)
+#define RENDER_MAX_COORD 1.0e6
+
+/// Screen vertex of a projected triangle (attributes divided by w)
+typedef struct _softVertex {
+	GLfloat x, y; ///< Window coordinates
+	GLfloat iw; ///< 1 / w (perspective correct interpolation)
+	GLfloat sf, sb, l; ///< Scalar front, scalar back and thickness (over w)
+} softVertex;
+
+/// ----------------------------------   cpuRenderer   ------------------------------------
+
+/// CPU Renderer
+
+class cpuRenderer {
+
+public:
+
+	/// Constructor
+	cpuRenderer();
+
+	/// Destructor
+	~cpuRenderer();
+
+	/// Set the pre-integration table
+	/// @arg _psi psi gamma table (front x back, row-major)
+	/// @arg _sizeBack table width (gamma back)
+	/// @arg _sizeFront table height (gamma front)
+	/// @return true if it succeed
+	bool init(const GLfloat *_psi, GLuint _sizeBack, GLuint _sizeFront);
+
+	/// Resize the frame buffer (nothing done if the size is the same)
+	/// @arg w width in pixels
+	/// @arg h height in pixels
+	/// @return true if it succeed
+	bool resize(GLuint w, GLuint h);
+
+	/// Clear the frame buffer
+	/// @arg r, g, b background color (alpha is cleared to 0)
+	void clear(GLfloat r, GLfloat g, GLfloat b);
+
+	/// Set brightness term (same as the hapt_dvr.frag uniform)
+	/// @arg _b brightness
+	void setBrightness(GLfloat _b) { brightness = _b; }
+
+	/// Render the tetrahedra in the given order (Direct Volume Rendering)
+	///   Tets are projected and split in triangles in parallel, binned
+	///   in screen tiles keeping the order, and each tile is composited
+	///   back-to-front by one thread
+	/// @arg vol volume with vertices (scalar in w), tetrahedra and transfer function
+	/// @arg ids back-to-front tetrahedra ids
+	/// @arg n number of ids
+	/// @arg mvp column-major modelview-projection matrix
+	void render(const offVol< GLfloat, GLuint >& vol, const GLuint *ids, GLuint n, const GLfloat *mvp);
+
+	/// @return frame buffer (RGBA float, bottom row first as glReadPixels)
+	const GLfloat *image(void) const { return frame; }
+
+	/// Frame buffer size
+	GLuint width(void) const { return frameW; }
+	GLuint height(void) const { return frameH; }
+
+	/// Number of triangles (and fragments) of the last render
+	GLuint numTriangles(void) const { return lastTris; }
+	unsigned long long numFragments(void) const { return lastFrags; }
+
+	/// Size of renderer data
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	/// Project one tetrahedron and split it in triangles (hapt_dvr.geom)
+	/// @arg v clip coordinates of the four vertices
+	/// @arg s scalars of the four vertices
+	/// @arg tris output triangles (3 vertices each, MAX_TET_TRIS)
+	/// @return number of triangles
+	GLuint projectTet(const GLfloat v[4][4], const GLfloat s[4], softVertex *tris) const;
+
+	/// Screen vertex from clip coordinates and attributes
+	void screenVertex(const GLfloat *c, GLfloat sf, GLfloat sb, GLfloat l, softVertex& sv) const;
+
+	/// Tiles overlapped by a triangle
+	/// @arg t triangle (3 vertices)
+	/// @arg tx0, ty0, tx1, ty1 returns the tile range (inclusive)
+	/// @return false if the triangle has no pixel on screen
+	bool tileBounds(const softVertex *t, GLint& tx0, GLint& ty0, GLint& tx1, GLint& ty1) const;
+
+	/// Rasterize one triangle inside a tile (hapt_dvr.frag and blending)
+	/// @arg t triangle (3 vertices)
+	/// @arg tf transfer function (numColors RGBA)
+	/// @arg numColors number of transfer function colors
+	/// @arg lScale thickness scale (brightness / maxEdgeLength)
+	/// @arg x0, y0, x1, y1 tile pixel bounds [x0, x1) x [y0, y1)
+	/// @return number of fragments
+	GLuint rasterize(const softVertex *t, const GLfloat *tf, GLuint numColors, GLfloat lScale,
+			 GLint x0, GLint y0, GLint x1, GLint y1);
+
+	const GLfloat *psi; ///< Psi gamma table
+	GLuint psiSizeBack, psiSizeFront; ///< Psi gamma table size
+
+	GLfloat brightness; ///< Brightness term
+
+	GLfloat *frame; ///< Frame buffer (RGBA)
+	GLuint frameW, frameH; ///< Frame buffer size
+
+	GLuint tilesX, tilesY; ///< Number of tiles per axis
+
+	GLfloat *clipVerts; ///< Clip coordinates of the vertices (4 per vertex)
+	GLuint numClipVerts; ///< Vertices allocated
+
+	softVertex *batchTris; ///< Triangles of a batch (MAX_TET_TRIS x 3 per tet)
+	GLubyte *batchCount; ///< Number of triangles of each tet of a batch
+
+	GLuint *tileStart; ///< Start of each tile list (numTiles + 1)
+	GLuint *tileTris; ///< Triangles of each tile, in order
+	GLuint tileTrisSize; ///< Tile lists allocated
+
+	GLuint *threadCount; ///< Triangles per thread and tile (binning)
+
+	GLuint lastTris; ///< Triangles of the last render
+	unsigned long long lastFrags; ///< Fragments of the last render
+
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   cpuSort : defines a class for multithreaded CPU sorting of the
+ *             tetrahedra centroids, used when no CUDA device is available.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _CPUSORT_H_
+#define _CPUSORT_H_
+
+extern "C" {
+#include <GL/gl.h> // OpenGL library
+}
+
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h> // OpenMP threads
+#else
+inline int omp_get_thread_num(void) { return 0; }
+inline int omp_get_num_threads(void) { return 1; }
+inline int omp_get_max_threads(void) { return 1; }
+#endif
+
+/// Radix sort digit size (in bits), number of buckets and passes for 32-bit keys
+#define RADIX_BITS 11
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES ((32 + RADIX_BITS - 1) / RADIX_BITS)
+
+/// Bucket (approximate) sort maximum number of bits, i.e. 2^k depth buckets
+#define BUCKET_BITS_MAX 16
+
+/// Per-thread histogram size (radix digits or depth buckets)
+#define HISTOGRAM_SIZE ( (RADIX_BUCKETS > (1 << BUCKET_BITS_MAX)) ? RADIX_BUCKETS : (1 << BUCKET_BITS_MAX) )
+
+/// Sample sort number of samples per bucket
+#define OVERSAMPLING 32
+
+/// Packed (in-place) sort digit size (in bits) and insertion sort cutoff
+#define PACKED_BITS 8
+#define PACKED_CUTOFF 32
+
+/// Packed key: 32-bit key (high word) and 32-bit id (low word)
+typedef unsigned long long int uint_64;
+
+typedef struct _tetCentroid {
+	GLuint id; ///< Tetrahedron index
+	GLfloat cZ; ///< Centroid Z
+	friend bool operator < (const struct _tetCentroid& t1, const struct _tetCentroid& t2) {
+		return t1.cZ < t2.cZ;
+	}
+} tetCentroid;
+
+/// ----------------------------------   cpuSort   ------------------------------------
+
+/// CPU Sort
+
+class cpuSort {
+
+public:
+
+	/// Constructor
+	cpuSort();
+
+	/// Destructor
+	~cpuSort();
+
+	/// Allocate the scratch arrays for sorting up to _n elements
+	/// @arg _n maximum number of elements to be sorted
+	/// @return true if it succeed
+	bool init(GLuint _n);
+
+	/// Size of CPU sort scratch memory
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// Monotone key of a float value: the unsigned order of
+	/// the keys is the same as the order of the floats
+	/// @arg f float value
+	/// @return 32-bit key
+	static GLuint floatKey(GLfloat f) {
+		GLuint u;
+		memcpy(&u, &f, sizeof(GLuint));
+		return (u & 0x80000000) ? ~u : (u | 0x80000000);
+	}
+
+	/// Float value of a monotone key (inverse of floatKey)
+	/// @arg k 32-bit key
+	/// @return float value
+	static GLfloat keyFloat(GLuint k) {
+		GLfloat f;
+		k = (k & 0x80000000) ? (k & 0x7FFFFFFF) : ~k;
+		memcpy(&f, &k, sizeof(GLfloat));
+		return f;
+	}
+
+	/// Radix sort
+	///   Parallel LSD radix sort (per-thread histograms) of n
+	///   32-bit keys, writing the ids (key index) in ascending
+	///   key order, i.e. back-to-front for centroid Z keys
+	/// @arg ids output sorted ids (only written)
+	/// @arg keys input keys (not modified)
+	/// @arg n number of keys
+	void radixSort(GLuint *ids, const GLuint *keys, GLuint n);
+
+	/// Adaptive sort
+	///   Repairs a nearly sorted sequence of keys (and ids) in place:
+	///   each thread insertion sorts one block, then neighbour blocks
+	///   are merged only where their key ranges overlap.  The cost
+	///   follows the number of inversions (order changes)
+	/// @arg ids ids following the keys (input and output)
+	/// @arg keys keys to be sorted (input and output)
+	/// @arg n number of keys
+	/// @arg maxDisorder maximum average insertion moves per key
+	/// @return false if the disorder exceeds the threshold (ids are
+	///         still a permutation, but not sorted)
+	bool adaptiveSort(GLuint *ids, GLuint *keys, GLuint n, GLfloat maxDisorder);
+
+	/// Sample sort
+	///   Parallel sample sort of tetrahedra centroids by centroid Z
+	///   (same order as std::sort with operator <).  One bucket per
+	///   thread is split by oversampled splitters, scattered and then
+	///   sorted independently.  It runs on the OpenMP thread team and
+	///   uses only the scratch arrays allocated in init
+	/// @arg c centroids to be sorted in place
+	/// @arg n number of centroids
+	void sampleSort(tetCentroid *c, GLuint n);
+
+	/// Bucket sort (approximate)
+	///   Quantizes the key depths in 2^bits uniform buckets between
+	///   the minimum and maximum depth and runs one parallel counting
+	///   sort pass.  Ties (same bucket) keep the id (spatial) order
+	/// @arg ids output ids ordered by bucket (only written)
+	/// @arg keys input monotone depth keys (see floatKey)
+	/// @arg n number of keys
+	/// @arg bits number of bucket bits (up to BUCKET_BITS_MAX)
+	/// @arg width returns the bucket width in depth units (if not NULL)
+	/// @arg inversions returns the number of neighbour ids in the output
+	///      with inverted depth, compared to the exact sort (if not NULL)
+	void bucketSort(GLuint *ids, const GLuint *keys, GLuint n, GLuint bits,
+			GLfloat *width = NULL, GLuint *inversions = NULL);
+
+	/// Packed sort (in place)
+	///   MSD radix sort of the high word (key) of packed keys, moving
+	///   whole 64-bit words in place (American flag sort), so no
+	///   scratch memory is needed.  The buckets of the first digit are
+	///   sorted in parallel.  Ids of equal keys are in any order
+	/// @arg p packed keys (input and output)
+	/// @arg n number of packed keys
+	static void packedSort(uint_64 *p, GLuint n);
+
+	/// Compaction
+	///   Copies the ids with a non-zero flag, keeping their order:
+	///   each thread counts and then fills its contiguous range
+	/// @arg out output ids (only written, not overlapping in)
+	/// @arg in input ids (NULL for the ids 0 to n-1)
+	/// @arg n number of input ids
+	/// @arg keep one flag per id
+	/// @arg threadCount scratch, one count per thread
+	/// @return number of ids written
+	static GLuint compact(GLuint *out, const GLuint *in, GLuint n, const GLubyte *keep, GLuint *threadCount);
+
+private:
+
+	/// Packed sort of one bucket from a digit down (one thread)
+	/// @arg p packed keys of the bucket
+	/// @arg n number of packed keys
+	/// @arg shift shift of the digit
+	static void packedSortBucket(uint_64 *p, GLuint n, GLint shift);
+
+	/// Merge two adjacent sorted runs [a, m) and [m, b) in place,
+	/// touching only the overlapping key range
+	void mergeRuns(GLuint *ids, GLuint *keys, GLuint a, GLuint m, GLuint b);
+
+	GLuint maxSize; ///< Maximum number of elements
+
+	GLuint maxThreads; ///< Maximum number of sorting threads
+
+	GLuint *keysTmp[2], *idsTmp[2]; ///< Ping-pong key/id arrays
+
+	GLuint *histograms; ///< Per-thread histograms (maxThreads x HISTOGRAM_SIZE)
+
+	tetCentroid *centroidTmp; ///< Sample sort scatter array
+
+	GLfloat *samples; ///< Sample sort samples (maxThreads x OVERSAMPLING)
+
+	GLuint *bucketCounts; ///< Sample sort per-thread bucket counts (maxThreads x maxThreads)
+
+};
+
+#endif
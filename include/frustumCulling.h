@@ -0,0 +1,114 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   frustumCulling : defines a class to build a bounding volume hierarchy
+ *                    over the tetrahedra and to cull the ones outside the
+ *                    view frustum, keeping a list of the tetrahedra in
+ *                    view to be sorted and drawn.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _FRUSTUMCULLING_H_
+#define _FRUSTUMCULLING_H_
+
+#include "appVol.h"
+
+#include "tetSubset.h"
+
+#include "centroidStore.h"
+
+/// Maximum number of tetrahedra in a leaf of the hierarchy
+#define BVH_LEAF_SIZE 256
+
+/// Leaf outside the frustum (planes of a leaf to be tested otherwise)
+#define BVH_OUTSIDE 0x80
+
+/// ----------------------------------   frustumCulling   ------------------------------------
+
+/// View-Frustum Culling
+
+class frustumCulling {
+
+public:
+
+	/// Constructor
+	frustumCulling();
+
+	/// Destructor
+	~frustumCulling();
+
+	/// Build the hierarchy
+	///   Each node splits its tets in two halves at the median centroid
+	///   of the longest axis (stored as a heap, children of node k are
+	///   2k+1 and 2k+2) and is bounded by the box of its tet vertices
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @arg c tetrahedra centroids
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol, const centroidStore& c);
+
+	/// @return true if the hierarchy is built
+	bool valid(void) const { return box != NULL; }
+
+	/// Update the list of tetrahedra in view
+	///   Lists the tets not entirely outside any frustum plane (see
+	///   subset), testing only the tets of the leaves whose box crosses
+	///   a plane, and keeps the frustum (see changed)
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @arg mvp column-major modelview-projection matrix
+	/// @arg mask one flag per tet, only flagged tets are listed (NULL for all)
+	void update(const offVol< GLfloat, GLuint >& vol, const GLfloat *mvp, const GLubyte *mask = NULL);
+
+	/// @arg mvp column-major modelview-projection matrix
+	/// @return true if the frustum is not the one of the last update
+	bool changed(const GLfloat *mvp) const { return memcmp( mvp, lastMVP, 16 * sizeof(GLfloat) ) != 0; }
+
+	/// @return tetrahedra in view (hierarchy order)
+	const tetSubset& subset(void) const { return visible; }
+	tetSubset& subset(void) { return visible; }
+
+	/// @return number of leaves
+	GLuint leaves(void) const { return numLeaves; }
+
+	/// @return number of leaves outside the frustum in the last update
+	GLuint culledLeaves(void) const { return numCulled; }
+
+	/// Size of frustum culling data
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	GLuint numLevels; ///< Number of levels of internal nodes
+
+	GLuint numLeaves; ///< Number of leaves
+
+	GLuint *perm; ///< Tets in hierarchy order (each node is a contiguous range)
+
+	GLuint *leafStart; ///< First tet of each leaf in perm (numLeaves + 1)
+
+	GLfloat *box; ///< Bounding box of each node, minimum and maximum (6 per node, heap order)
+
+	GLubyte *leafPlanes; ///< Planes crossed by each leaf in the last update (or BVH_OUTSIDE)
+
+	GLuint *leafKept; ///< Tets in view of each leaf (listing)
+
+	GLuint *leafIds; ///< Tets in view of each leaf, at its perm range (listing)
+
+	tetSubset visible; ///< Tets in view
+
+	GLuint numCulled; ///< Leaves outside the frustum
+
+	GLfloat lastMVP[16]; ///< Modelview-projection of the last update
+
+};
+
+#endif
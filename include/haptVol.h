@@ -27,6 +27,34 @@
 
 #include "centroid.cuh"
 
+#include "cpuSort.h"
+
+#include "centroidStore.h"
+
+#include "quantizedCentroids.h"
+
+#include "cpuRenderer.h"
+
+#include "screenTiles.h"
+
+#include "tfCulling.h"
+
+#include "intervalTree.h"
+
+#include "frustumCulling.h"
+
+#include "orderCache.h"
+
+#include "normalBins.h"
+
+#include "kdTree.h"
+
+#include "brickGrid.h"
+
+#include "sortPipeline.h"
+
+#include "visibilitySorter.h"
+
 #include <vcg/math/matrix44.h>
 #include <wrap/gl/math.h>
 
@@ -34,17 +62,25 @@
 #define WHITE 1.0f, 1.0f, 1.0f
 #define BLACK 0.0f, 0.0f, 0.0f
 
-enum sortType { none, stl_sort, gpu_bitonic, gpu_quick, mpvo, compare_sort }; ///< Sort methods
+/// MPVO per-tet state bits (one byte per tet): incoming arrow (adjacent
+/// tet drawn before) of face j, visited and on-stack (cycle check) flags,
+/// and the face being traversed by the DFS (2 bits)
+#define MPVO_DAG(j) (1 << (j))
+#define MPVO_DAG_MASK 0x0F
+#define MPVO_VISITED 0x10
+#define MPVO_ONSTACK 0x20
+#define MPVO_FACE_SHIFT 6
 
-enum drawType { dvr, isos, dvr_isos }; ///< Draw methods (Direct Volume Rendering and/or Iso-Surfaces)
+/// Front-to-back compositing: early termination passes per draw and
+/// smallest batch of tets drawn between two passes
+#define TERMINATION_PASSES 8
+#define TERMINATION_BATCH 4096
 
-typedef struct _tetCentroid {
-	GLuint id; ///< Tetrahedron index
-	GLfloat cZ; ///< Centroid Z
-	friend bool operator < (const struct _tetCentroid& t1, const struct _tetCentroid& t2) {
-		return t1.cZ < t2.cZ;
-	}
-} tetCentroid;
+enum sortType { none, stl_sort, gpu_bitonic, gpu_quick, mpvo, compare_sort, cpu_radix, cpu_incremental, cpu_bucket, mpvo_parallel, cpu_cached, mpvo_incremental, kd_tree, brick_sort, cpu_compact,
+		num_sort_types, ///< Built-in sort methods, plug-in sorters take the next ids
+		max_sort_types = MAX_SORTERS }; ///< Sort methods (ids in the sorter registry)
+
+enum drawType { dvr, isos, dvr_isos }; ///< Draw methods (Direct Volume Rendering and/or Iso-Surfaces)
 
 /// ----------------------------------   haptVol   ------------------------------------
 
@@ -64,12 +100,17 @@ public:
 
 	/// Size of PT Volume (OpenGL in CPU)
 	/// @return openGL usage in Bytes
-	int sizeOf(void);
+	size_t sizeOf(void);
+
+	/// Size of the sort bookkeeping (centroids, keys, ids and sorter data)
+	/// @return sort memory usage in Bytes
+	size_t sortSizeOf(void);
 
 	/// Set functions
 	void setColor(const GLclampf& _r, const GLclampf& _g, const GLclampf& _b) {
 		backGround = vec3( _r, _g, _b );
-		glClearColor(backGround.r(), backGround.g(), backGround.b(), 0.0);
+		if( frontToBack ) glClearColor(0.0, 0.0, 0.0, 0.0); ///< Background composited under the volume
+		else glClearColor(backGround.r(), backGround.g(), backGround.b(), 0.0);
 	}
 
 	/// OpenGL Setup
@@ -82,7 +123,17 @@ public:
 
 	/// Set use buffer object flag
 	/// @arg _b new buffer object usage flag
-	void useBufferObject(bool _b = true) { useBufObj = _b; }
+	void useBufferObject(bool _b = true) { useBufObj = _b || compactMode; invalidateSortCache(); }
+
+	/// Set compact sort mode (before glSetup or sortSetup)
+	///   Keeps only 16-bit quantized centroids and packed 32-bit depth
+	///   keys with ids (14 B/tet), sorted in place straight into the
+	///   mapped element buffer.  Only the cpu_compact sorter is available
+	/// @arg _c new compact mode flag
+	void useCompactSort(bool _c = true) { compactMode = _c; if( _c ) useBufObj = true; }
+
+	/// @return true if in compact sort mode
+	bool compactSort(void) const { return compactMode; }
 
 	/// Set use illumination flag
 	/// @arg _l new illumination usage flag
@@ -97,9 +148,257 @@ public:
 		sort(_sT);
 		gettimeofday(&endtime, 0);
 		_t = (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
+		if( sortSkipped ) { ++sortCacheHits; sortSkippedTime += lastSortTime; return; }
+		lastSortTime = _t;
+		if( measureError && _sT != none ) computeCentroidSortError( _sT );
 	}
 	void sort(sortType _sT);
 
+	/// Setup only the sort data structures (no OpenGL calls), to
+	/// sort without a window with sort(sortType, const GLfloat*)
+	/// @return true if it succeed
+	bool sortSetup(void);
+
+	/// Sort for a modelview (no OpenGL calls, no reuse of the last order)
+	/// @arg _sT sort method
+	/// @arg mv column-major modelview matrix
+	void sort(sortType _sT, const GLfloat *mv);
+
+	/// @return back-to-front ids of the last sort in CPU
+	const GLuint *getIds(void) const { return ids; }
+
+	/// Pipelined sort
+	///   Requests a sort of the current view to the worker thread and
+	///   uploads the newest completed order to the next element buffer
+	///   (waiting on its fence), used by the following draw
+	///   Sort methods not running in the worker (see pipelineSorts)
+	///   keep the last order
+	/// @arg _t returns time spent in the OpenGL thread (in seconds)
+	/// @arg _sT sort method
+	void pipelineSort(GLdouble& _t, sortType _sT = none);
+
+	/// Set pipelined mode
+	///   Sorts run in a worker thread overlapped with drawing, which
+	///   uses the last completed order (triple buffered, the tets in id
+	///   order before the first one).  Draws are fenced when sync
+	///   objects are available, the buffers orphaned otherwise
+	/// @arg _p new pipelined mode flag
+	/// @return true if it succeed
+	bool usePipeline(bool _p = true);
+
+	/// Pipeline state
+	/// @return true if the pipelined mode is on
+	bool pipelineOn(void) const { return pipelined; }
+	/// @return true if a sort is pending or not yet drawn
+	bool pipelineBusy(void) { return pipelined && pipeline.busy(); }
+	/// @return time of the last sort in the worker thread (in seconds)
+	GLdouble getPipelineSortTime(void) { return pipeline.sortTime(); }
+	/// @arg _sT sort method
+	/// @return true if the sort method runs in the worker thread (CUDA
+	///         sorts run only in the OpenGL thread, the one of their context)
+	bool pipelineSorts(sortType _sT) const {
+#ifdef NO_CUDA
+		return _sT != none;
+#else
+		return _sT != none && _sT != gpu_bitonic && _sT != gpu_quick;
+#endif
+	}
+
+	/// Set sort-first mode (screen tiles)
+	///   The tets are binned in screen tiles by their projected bounding
+	///   box, each tile list is sorted by the centroid depth on its own
+	///   (in parallel) and drawn with a scissor around its tile.  The
+	///   sort method only turns sorting on or off.  Not available in
+	///   compact or pipelined mode
+	/// @arg _s new sort-first flag
+	/// @return true if it succeed
+	bool useSortFirst(bool _s = true);
+
+	/// @return true if in sort-first mode
+	bool sortFirstOn(void) const { return sortFirst; }
+
+	/// Set sort-first tile size (in pixels)
+	void setTileSize(GLuint _s) { tiles.setTileSize(_s); }
+
+	/// @return sort-first screen tiles of the last sort
+	const screenTiles& getScreenTiles(void) const { return tiles; }
+
+	/// Set front-to-back compositing (after glSetup)
+	///   The sorts output front-to-back (reversed depth row) and the tets
+	///   are composited with the under operator on the opacity kept in
+	///   the destination alpha.  Between batches of the draw the pixels
+	///   more opaque than the termination opacity are marked in the
+	///   stencil buffer, so the next tets covering them are rejected
+	///   before the fragment shader.  Needs alpha and stencil bits
+	/// @arg _f new front-to-back flag
+	/// @return true if it succeed
+	bool useFrontToBack(bool _f = true);
+
+	/// @return true if compositing front-to-back
+	bool frontToBackOn(void) const { return frontToBack; }
+
+	/// Set the accumulated opacity to stop compositing a pixel
+	/// @arg _o termination opacity in [0, 1]
+	void setTerminationOpacity(GLfloat _o) { terminationOpacity = (_o < 0.0) ? 0.0 : ( (_o > 1.0) ? 1.0 : _o ); }
+
+	/// @return termination opacity
+	GLfloat getTerminationOpacity(void) const { return terminationOpacity; }
+
+	/// Set empty-tet culling (DVR)
+	///   Only the tets whose scalar range has some opacity under the
+	///   transfer function are sorted and drawn (STL and radix sorts
+	///   sort only the visible list, other orders are filtered).  The
+	///   list is rebuilt by refreshTFandBrightness.  Not available in
+	///   compact or pipelined mode
+	/// @arg _c new culling flag
+	/// @return true if it succeed
+	bool useEmptyCulling(bool _c = true);
+
+	/// @return true if empty tets are culled
+	bool emptyCullingOn(void) const { return cullEmpty; }
+
+	/// @return number of tets visible under the transfer function
+	GLuint getVisibleTets(void) const { return culling.subset().size(); }
+
+	/// @return number of tets in the order of the last sort (drawn)
+	GLuint getDrawCount(void) const { return drawCount; }
+
+	/// Set the active-cell index (iso-surfaces)
+	///   Only the tets crossed by the iso-values, listed by an interval
+	///   tree over the tet scalar ranges, are sorted and drawn in isos
+	///   mode (on by default).  The list is rebuilt by refreshISO.  Not
+	///   used in compact or pipelined mode
+	/// @arg _i new index flag
+	void useIsoIndex(bool _i = true) { indexIsos = _i; invalidateSortCache(); }
+
+	/// @return true if the active-cell index is used
+	bool isoIndexOn(void) const { return indexIsos; }
+
+	/// @return number of tets crossed by the iso-values
+	GLuint getActiveTets(void) const { return isoIndex.subset().size(); }
+
+	/// Set view-frustum culling
+	///   Only the tets inside the view frustum, found by a bounding
+	///   volume hierarchy built at load, are sorted and drawn, so
+	///   zoomed views cost less than full views.  The frustum is the
+	///   projection and modelview of the sort (the projection of the
+	///   last sort(_sT) for sort(_sT, mv), identity before).  Not used
+	///   in compact or pipelined mode
+	/// @arg _f new frustum culling flag
+	void useFrustumCulling(bool _f = true) { cullFrustum = _f; invalidateSortCache(); }
+
+	/// @return true if the tets outside the view frustum are culled
+	bool frustumCullingOn(void) const { return cullFrustum; }
+
+	/// @return number of tets in the view frustum of the last sort
+	GLuint getTetsInView(void) const { return frustum.subset().size(); }
+
+	/// @return bounding volume hierarchy of the frustum culling
+	const frustumCulling& getFrustumCulling(void) const { return frustum; }
+
+	/// Set the view tolerance to reuse the last order
+	///   The sort is skipped if the sort method is the same and the
+	///   view direction changed less than the tolerance (0 means only
+	///   an unchanged view is reused)
+	/// @arg _a angular tolerance in degrees
+	void setViewTolerance(GLfloat _a) { viewTolerance = (_a < 0.0) ? 0.0 : _a; }
+	/// @return angular tolerance in degrees
+	GLfloat getViewTolerance(void) const { return viewTolerance; }
+
+	/// Forget the last view, forcing the next sort
+	void invalidateSortCache(void) { lastViewValid = false; }
+
+	/// Sort cache statistics
+	/// @return number of sorts skipped since the start
+	GLuint getSortCacheHits(void) const { return sortCacheHits; }
+	/// @return sort time saved by the skipped sorts (in seconds)
+	GLdouble getSortSkippedTime(void) const { return sortSkippedTime; }
+	/// @return true if the last sort was skipped
+	bool lastSortWasSkipped(void) const { return sortSkipped; }
+
+	/// Set measure sort error flag
+	///   When set, the visibility error of each sort is measured after it
+	/// @arg _m new measure sort error flag
+	void measureSortError(bool _m = true) { measureError = _m; }
+
+	/// Compute the centroid sort error
+	///   Traverses the adjacency list (con file) and, for the current
+	///   view, counts the neighbour tets drawn in the wrong order by
+	///   the current ordering, weighted by their shared face area
+	/// @arg _sT sort method that produced the current ordering
+	void computeCentroidSortError( sortType _sT );
+
+	/// Compute the sort error of an ordering for a view (no OpenGL calls)
+	/// @arg _sT sort method that produced the ordering
+	/// @arg mv column-major modelview matrix
+	/// @arg order sorted ids (front-to-back when compositing front-to-back)
+	/// @arg n number of ids in order (the faces of the tets not in it are skipped)
+	void computeSortError( sortType _sT, const GLfloat *mv, const GLuint *order, GLuint n );
+
+	/// Visibility error of the last measured sort of a given method
+	/// @arg _sT sort method
+	/// @return fraction of the interior faces area with inverted tets, or -1 if not measured
+	GLfloat getSortError(sortType _sT) const { return sortErrorArea[_sT]; }
+	/// @return fraction of the interior faces with inverted tets, or -1 if not measured
+	GLfloat getSortErrorFaces(sortType _sT) const { return sortErrorFaces[_sT]; }
+
+	/// Sorter registry: built-in sort methods (ids as sortType) and plug-ins
+	const sorterRegistry& getSorters(void) const { return sorters; }
+
+	/// Sorter name
+	/// @arg _sT sort method
+	/// @return name shown in the information box
+	const char *getSorterName(sortType _sT) const {
+		return ( sorters.get(_sT) ) ? sorters.get(_sT)->name() : "None";
+	}
+
+	/// Sort method state of the last sort (written by the worker
+	/// thread while pipelined, only read when not pipelined)
+
+	/// Incremental sort state
+	/// @return true if the last incremental sort repaired the previous
+	///         frame order, false if it fell back to a full sort
+	bool incrementalRepaired(void) const { return lastRepaired; }
+
+	/// Cached directions sort state
+	/// @return stored direction used by the last cached sort
+	GLuint getCachedDirection(void) const { return lastCachedDir; }
+	/// @return number of stored directions (0 if the cache is not loaded)
+	GLuint getCachedDirections(void) const { return viewOrders.size(); }
+
+	/// Set the incremental sort disorder threshold
+	/// @arg _d maximum average insertion moves per tet before a full sort
+	void setMaxDisorder(GLfloat _d) { maxDisorder = _d; }
+
+	/// Set the approximate (bucket) sort precision
+	///   Not while pipelined (the worker thread reads it)
+	/// @arg _b number of bits k, i.e. 2^k depth buckets
+	/// @return true if it succeed
+	bool setBucketBits(GLuint _b) {
+		if( pipelined ) return false;
+		bucketBits = (_b < 1) ? 1 : ( (_b > BUCKET_BITS_MAX) ? BUCKET_BITS_MAX : _b );
+		invalidateSortCache();
+		return true;
+	}
+
+	/// Approximate (bucket) sort precision and error
+	/// @return number of bits k, i.e. 2^k depth buckets
+	GLuint getBucketBits(void) const { return bucketBits; }
+	/// @return bucket width in depth units of the last bucket sort
+	GLfloat getBucketWidth(void) const { return bucketWidth; }
+	/// @return fraction of neighbour tets out of the exact (stl) order
+	GLfloat getBucketError(void) const {
+		return (volume.numTets > 1) ? bucketInversions / (GLfloat)(volume.numTets - 1) : 0.0;
+	}
+
+	/// @return number of cycles detected by the last MPVO sort
+	GLuint getMPVOCycles(void) const { return DFScycles; }
+
+	/// @return number of faces revisited by the last incremental DAG
+	GLuint getDAGRevisited(void) const { return dagRevisited; }
+	/// @return number of interior faces
+	GLuint getDAGFaces(void) const { return faceBins.numFaces(); }
+
 	/// Draw
 	///   Draw Arrays using one OpenGL function: glDrawArrays
 	///   to draw all vertices and its attributes stored into
@@ -114,6 +413,36 @@ public:
 	}
 	void draw(void);
 
+	/// Software Draw
+	///   Draw the current view and order with the multithreaded CPU
+	///   renderer (DVR only) and copy the image to the window
+	/// @arg _t returns total time spent in drawing (in seconds)
+	void softwareDraw(GLdouble& _t) {
+		static struct timeval starttime, endtime;
+		gettimeofday(&starttime, 0);
+		softwareDraw();
+		gettimeofday(&endtime, 0);
+		_t = (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
+	}
+	void softwareDraw(void);
+
+	/// Software Draw without a window (no OpenGL calls)
+	/// @arg w image width
+	/// @arg h image height
+	/// @arg mvp column-major modelview-projection matrix
+	/// @arg order back-to-front ids (default the ids of the last sort)
+	/// @arg n number of ids in order (default the tets of the last sort)
+	/// @return true if it succeed
+	bool softwareDraw(GLuint w, GLuint h, const GLfloat *mvp, const GLuint *order = NULL, GLuint n = 0);
+
+	/// Set the brightness term of the software draw (no OpenGL calls,
+	/// refreshTFandBrightness also sets it)
+	/// @arg _b brightness
+	void setSoftwareBrightness(GLfloat _b) { softBrightness = _b; }
+
+	/// @return CPU renderer with the image of the last software draw
+	const cpuRenderer& getSoftwareRenderer(void) const { return softRenderer; }
+
 	/// Refresh Transfer Function (TF) and Brightness
 	/// @arg brightness term
 	void refreshTFandBrightness(GLfloat brightness = 1.0);
@@ -130,6 +459,13 @@ private:
 	/// @return true if it succeed
 	bool createArrays(void);
 
+	/// Create the CPU arrays used by the sorts (ids and MPVO) and the
+	/// sorter registry (after createCentroidSorts)
+	/// @arg hostIds create the ids array (not needed by the compact
+	///      sort with buffer objects)
+	/// @return true if it succeed
+	bool createSortArrays(bool hostIds = true);
+
 	/// Create Centroid Sorts
 	/// centroidSorted: {  (tetId, centroidZ), ... }
 	/// @return true if it succeed
@@ -146,37 +482,188 @@ private:
 	/// @return true if it succeed
 	bool createShaders(void);
 
-	/// Compute the centroid sort error
-	/// Traverses the adjacency list (con file)
-	void computeCentroidSortError( void );
+	/// View direction in object space
+	///   The depth row of the modelview, i.e. the direction the centroid
+	///   sorts order by.  Equal (up to scale) to the former DAG direction,
+	///   the eye-space point (0, 0, -1) through the inverted modelview,
+	///   when the modelview has no translation; unlike that point it does
+	///   not move with a trackball pan
+	/// @arg mv column-major modelview matrix
+	/// @return direction looking into the screen (not normalized)
+	static vec3 viewDirection(const GLfloat *mv) {
+		return vec3( -mv[2], -mv[6], -mv[10] );
+	}
+
+	/// Read the view-direction order cache file, or build it in
+	/// parallel and write it if it does not exist
+	/// @return true if it succeed
+	bool loadOrderCache( void );
+
+	/// Built-in sort method in the sorter registry
+	class builtinSorter;
+
+	/// Register the built-in sort methods and the plug-in sorters
+	/// @return true if it succeed
+	bool createSorters(void);
+
+	/// Sort the tets with a registered sorter
+	///   (no OpenGL calls, it runs in the worker thread when pipelined)
+	/// @arg _sT sort method
+	/// @arg out output sorted ids
+	/// @arg mv column-major modelview matrix
+	/// @return number of ids written (visible tets or active cells for a subset)
+	GLuint sortIds(sortType _sT, GLuint *out, const GLfloat *mv);
+
+	/// Run a registered sorter, all tets (pipeline worker, see sortIds)
+	/// @arg _sT sort method
+	/// @arg out output sorted ids
+	/// @arg mv column-major modelview matrix, as given by sortView
+	/// @return false if the sorter is not registered
+	bool runSorter(sortType _sT, GLuint *out, const GLfloat *mv);
+
+	/// Modelview handed to the sorters, with the depth row reversed
+	/// when compositing front-to-back
+	/// @arg smv output sort modelview
+	/// @arg mv column-major modelview matrix
+	void sortView(GLfloat *smv, const GLfloat *mv) const;
+
+	/// Build the sort data a method builds on first use (k-d tree, bricks,
+	/// packed keys, order cache), in the OpenGL thread before a
+	/// pipelined sort
+	/// @arg _sT sort method
+	void prepareSort(sortType _sT);
+
+	/// Built-in sort methods: sort the tets with the modelview mv,
+	/// writing to out (the subset list only for STL and radix)
+	void sortSTL( GLuint *out, const GLfloat *mv ); ///< Parallel sample sort (std::sort order)
+	void sortRadix( GLuint *out, const GLfloat *mv ); ///< Parallel radix sort
+	void sortIncremental( GLuint *out, const GLfloat *mv ); ///< Repair of the previous frame order
+	void sortCached( GLuint *out, const GLfloat *mv ); ///< Repair of the nearest cached direction order
+	void sortBucket( GLuint *out, const GLfloat *mv ); ///< Approximate (bucket) sort
+	void sortBricks( GLuint *out, const GLfloat *mv ); ///< Brick two-level sort
+	void sortKdTree( GLuint *out, const GLfloat *mv ); ///< k-d tree traversal
+	void sortMPVO( GLuint *out, const GLfloat *mv ) { MPVO( out, mv ); } ///< MPVO
+	void sortMPVOIncremental( GLuint *out, const GLfloat *mv ) { MPVO( out, mv, true ); } ///< MPVO with incremental DAG
+	void sortBitonic( GLuint *out, const GLfloat *mv ); ///< Bitonic sort (centroid.cuh)
+	void sortQuick( GLuint *out, const GLfloat *mv ); ///< Quick sort (centroid.cuh)
+	void sortCompact( GLuint *out, const GLfloat *mv ); ///< In-place packed key sort (compact mode)
+
+	/// Size of the data a built-in sort method uses (arrays shared by
+	/// several methods are reported by each of them)
+	/// @arg _sT sort method
+	/// @return memory usage in Bytes
+	size_t sortMethodSizeOf(sortType _sT);
+
+	/// Sort-first sort: bin and sort the tets in screen tiles (current
+	/// modelview, projection and viewport) and upload the tile lists
+	void sortTiles( void );
+
+	/// Sort-first draw: draw each tile list with a scissor around its tile
+	void drawTiles( void );
+
+	/// Draw a range of the order from the bound element buffer (order
+	/// NULL) or from the CPU, front-to-back in batches separated by
+	/// early termination passes
+	/// @arg order element indices in CPU (or NULL)
+	/// @arg first first element
+	/// @arg count number of elements
+	/// @arg rect window rectangle drawn (x, y, width, height)
+	void drawOrder( const GLuint *order, GLuint first, GLuint count, const GLint *rect );
+
+	/// Early termination pass: mark the pixels of the rectangle more
+	/// opaque than the termination opacity in the stencil buffer (the
+	/// frame buffer copied onto itself with alpha test, no color written)
+	/// @arg rect window rectangle (x, y, width, height)
+	void terminationPass( const GLint *rect );
+
+	/// Composite the background under the volume (front-to-back)
+	void drawBackground( void );
+
+	/// Repair sort of cpu_incremental and cpu_cached
+	/// @arg out output sorted ids
+	/// @arg mv column-major modelview matrix
+	/// @arg cached start from the nearest cached direction order
+	void repairSort( GLuint *out, const GLfloat *mv, bool cached );
+
+	/// Sort function of the pipeline worker thread
+	static void pipelineSortIds(void *obj, GLint method, const GLfloat *mv, GLuint *order);
+
+	/// Check if the last order can be reused
+	/// @arg _sT sort method
+	/// @arg mv column-major modelview matrix
+	/// @return true if the sort method and the translation are the
+	///         same and the view direction did not change more than
+	///         the view tolerance
+	bool viewUnchanged(sortType _sT, const GLfloat *mv) const;
 
 	/// Compute view-dependent DAG (Direct Acyclic Graph)
 	/// Second step of the MVPO
+	/// @arg mv column-major modelview matrix
 	/// @return Number of front facing boundary tets
-	GLuint DAG( void );
+	GLuint DAG( const GLfloat *mv );
 
 	/// From the DAG extract the view-depent ordering in depth-first-search manner
-	/// Third step of the MVPO
+	/// Third step of the MVPO.  Uses an explicit stack (no recursion)
 	/// @param Cell id
-	void DFS ( GLuint );
+	/// @param Output ids (at DFScount)
+	void DFS ( GLuint, GLuint * );
 
 	/// Meshed Polyhedra Visibility Ordering for Non Convex Meshes
 	/// [Peter L. Williams : Visibility-OrderingMeshed Polyhedra. ACM
 	/// Trans. Graph. 11, 2, 1992]
-	void MPVO( void );
+	/// @arg out output sorted ids
+	/// @arg mv column-major modelview matrix
+	/// @arg incremental update the DAG incrementally (see incrementalDAG)
+	void MPVO( GLuint *out, const GLfloat *mv, bool incremental = false );
+
+	/// Compute view-dependent DAG in parallel, one face per direction
+	/// decision, and the number of successors of each tet
+	/// @arg mv column-major modelview matrix
+	/// @return Number of front facing boundary tets
+	GLuint parallelDAG( const GLfloat *mv );
+
+	/// Update the view-dependent DAG incrementally
+	///   Interior faces are grouped by normal direction, only the bins
+	///   that changed side of the view plane or straddle it are
+	///   revisited.  The front-facing boundary tets are taken from the
+	///   external faces list
+	/// @arg mv column-major modelview matrix
+	/// @return Number of front facing boundary tets
+	GLuint incrementalDAG( const GLfloat *mv );
+
+	/// Parallel MPVO for Non Convex Meshes
+	///   Level-synchronous (Kahn) topological sort of the DAG: starting
+	///   from the sorted front-facing boundary tets without successors,
+	///   each level holds the tets whose successors were all output and
+	///   is processed across threads.  Levels are written back-to-front
+	/// @arg out output sorted ids
+	/// @arg mv column-major modelview matrix
+	void parallelMPVO( GLuint *out, const GLfloat *mv );
 
 	glslKernel *haptShader; ///< HAPT shader
 
 	GLuint *ids; ///< Tetrahedra ids for rendering
 
-	ivec4 *dag; ///< MPVO, directions for complementing the connectivity
-	
-	bool *visited; ///< MPVO, visited flag for DFS algorithm
-
-	bool *visitedCycle; ///< MPVO, visited flag for checking cycles, part of MPVO
+	GLubyte *mpvoState; ///< MPVO, DAG directions, visited and on-stack bits (see MPVO_*)
 
 	GLuint DFScount; ///< MPVO, counter for outputing the ordered cells into the ids list
 
+	GLuint DFScycles; ///< MPVO, number of cycles detected by the last DFS
+
+	normalBins faceBins; ///< Incremental MPVO, interior faces binned by normal direction
+
+	GLuint dagRevisited; ///< Incremental MPVO, faces revisited by the last DAG update
+
+	GLuint *mpvoCount; ///< Parallel MPVO, number of successors not yet output of each tet
+
+	GLuint *mpvoQueue; ///< MPVO, DFS stack or (parallel) tets in level order (front-to-back)
+
+	GLuint mpvoThreads; ///< Parallel MPVO, maximum number of threads
+
+	GLuint *mpvoOffsets; ///< Parallel MPVO, output offset of each thread
+
+	GLuint *mpvoNext; ///< Parallel MPVO, next level tets released by each thread
+
 	GLfloat *bufArray[4]; ///< Buffer arrays
 
 	GLuint bufObject[5]; ///< Vertex Buffer Objects
@@ -189,11 +676,144 @@ private:
 
 	tetCentroid *centroidSorted; ///< STL sorting
 
-	vec3 *centroidList; ///< Tetrahedron centroids list
+	GLuint *depthKeys; ///< Monotone 32-bit centroid Z keys (CPU radix sorting)
+
+	cpuSort cpuSorter; ///< Multithreaded CPU sorting
+
+	GLuint *prevOrder; ///< Previous frame back-to-front order (incremental sorting)
+
+	bool prevOrderValid; ///< Flag to tell if the previous frame order exists
+
+	bool lastRepaired; ///< Flag to tell if the last incremental sort was a repair
+
+	GLfloat maxDisorder; ///< Incremental sort threshold to fall back to a full sort
+
+	GLuint bucketBits; ///< Approximate sort precision (2^bucketBits depth buckets)
+
+	GLfloat bucketWidth; ///< Approximate sort bucket width (depth error bound)
+
+	GLuint bucketInversions; ///< Approximate sort neighbours out of the exact order
+
+	GLfloat sortMV[16]; ///< Modelview of the current sort
+
+	GLfloat sortProj[16]; ///< Projection of the current sort (frustum culling and sort-first)
+
+	sorterRegistry sorters; ///< Sort methods by sortType
+
+	bool pipelined; ///< Flag to sort in the worker thread (pipelined mode)
+
+	sortPipeline pipeline; ///< Sort worker thread and order slots
+
+	GLuint pipeBufObject[NUM_SORT_SLOTS]; ///< Pipelined element buffers
+
+	void *pipeFence[NUM_SORT_SLOTS]; ///< Fences of the draws from each element buffer
+
+	bool syncObjects; ///< Flag to fence the pipelined draws (ARB_sync, checked at run time)
+
+	GLint pipeDraw; ///< Element buffer with the last completed order (-1 if none)
+
+	bool lastViewValid; ///< Flag to tell if the last view can be reused
+
+	sortType lastViewSort; ///< Sort method of the last view
+
+	GLfloat lastView[6]; ///< Depth row and translation of the modelview of the last sort
+
+	GLfloat viewTolerance; ///< Angular tolerance (degrees) to reuse the last order
+
+	bool sortSkipped; ///< Flag to tell if the last sort was skipped
+
+	GLuint sortCacheHits; ///< Number of skipped sorts
+
+	GLdouble lastSortTime, sortSkippedTime; ///< Last sort time and total time saved
+
+	bool measureError; ///< Flag to measure the visibility error of each sort
+
+	GLfloat sortErrorArea[max_sort_types]; ///< Visibility error of each sort (inverted face area)
+
+	GLfloat sortErrorFaces[max_sort_types]; ///< Visibility error of each sort (inverted faces)
+
+	centroidStore centroids; ///< Tetrahedron centroids (SoA)
+
+	brickGrid bricks; ///< Spatial bricks of tets (two-level sorting)
+
+	bool compactMode; ///< Flag to keep only the compact sort data
+
+	quantizedCentroids qCentroids; ///< Quantized centroids (compact sorting)
+
+	uint_64 *packedIds; ///< Packed depth keys and ids (compact sorting)
+
+	bool cudaReady; ///< Flag to tell if initCUDA was called
+
+	bool sortFirst; ///< Flag to sort and draw in screen tiles (sort-first mode)
+
+	screenTiles tiles; ///< Sort-first screen tiles
+
+	GLuint tileBufObject; ///< Sort-first element buffer (tile lists)
+
+	bool frontToBack; ///< Flag to composite front-to-back with early termination
+
+	GLfloat terminationOpacity; ///< Opacity to stop compositing a pixel (front-to-back)
+
+	bool cullEmpty; ///< Flag to cull the tets with no opacity (DVR)
+
+	tfCulling culling; ///< Tet scalar ranges and visible list
+
+	GLuint drawCount; ///< Number of tets in the current order
+
+	/// @return true if the sorts and draws use only the visible tets
+	bool cullActive(void) const { return !pipelined && cullEmpty && drawMode == dvr; }
+
+	bool indexIsos; ///< Flag to draw only the active cells of the iso-surfaces
+
+	intervalTree isoIndex; ///< Interval tree of the tet scalar ranges and active list
+
+	/// Active cells of the current iso-values
+	void activeIsoCells(void);
+
+	/// @return true if the sorts and draws use only the active cells
+	bool isoIndexActive(void) const { return !pipelined && indexIsos && drawMode == isos && isoIndex.valid(); }
+
+	/// Subset of the tets sorted and drawn (in view, active cells or visible)
+	///   Never while pipelined: pipelined is tested first, so the sorts
+	///   in the worker thread read only that flag (set before the
+	///   worker starts and cleared after it stops)
+	/// @return the subset, or NULL if all tets are sorted and drawn
+	tetSubset *activeSubset(void) {
+		if( frustumActive() ) return &frustum.subset();
+		if( isoIndexActive() ) return &isoIndex.subset();
+		return ( cullActive() ) ? &culling.subset() : NULL;
+	}
+
+	bool cullFrustum; ///< Flag to cull the tets outside the view frustum
+
+	frustumCulling frustum; ///< Bounding volume hierarchy and tets in view
+
+	/// @return true if the sorts and draws use only the tets in view
+	bool frustumActive(void) const { return !pipelined && cullFrustum && frustum.valid(); }
+
+	/// Modelview-projection of the current sort
+	/// @arg mvp returns sortProj * sortMV (column-major)
+	void sortMVP(GLfloat *mvp) const;
+
+	/// Tets in the view frustum of the current sort (among the visible
+	/// tets or active cells, if used)
+	void cullToFrustum(void);
+
+	kdTree spatialTree; ///< k-d tree over the centroids (built on first use)
+
+	orderCache viewOrders; ///< Precomputed orders of a set of view directions
+
+	bool orderCacheTried; ///< Flag to tell if the order cache was already loaded or built
+
+	GLuint lastCachedDir; ///< Stored direction used by the last cached sort
 
 	GLuint orderTableTex, tfanOrderTableTex,
 		tfTex, psiGammaTableTex; ///< Textures used in shaders
 
+	cpuRenderer softRenderer; ///< Multithreaded CPU renderer (software draw)
+
+	GLfloat softBrightness; ///< Brightness term of the software draw
+
 	vec3 backGround; ///< Background color
 
 };
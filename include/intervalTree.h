@@ -0,0 +1,93 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   intervalTree : defines a class to index the tetrahedra scalar ranges
+ *                  in an interval tree and to list the active cells, i.e.
+ *                  the tetrahedra crossed by the iso-surfaces.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _INTERVALTREE_H_
+#define _INTERVALTREE_H_
+
+#include "appVol.h"
+
+#include "tetSubset.h"
+
+/// Interval tree node: tets whose scalar range contains the center
+typedef struct _intervalNode {
+	GLfloat center; ///< Split value (median of the range midpoints)
+	GLuint first, count; ///< Node tets in the sorted lists
+	GLint left, right; ///< Children with the ranges below and above the center (-1 for none)
+} intervalNode;
+
+/// ----------------------------------   intervalTree   ------------------------------------
+
+/// Interval Tree
+
+class intervalTree {
+
+public:
+
+	/// Constructor
+	intervalTree();
+
+	/// Destructor
+	~intervalTree();
+
+	/// Build the tree
+	///   Each node splits its tets at the median midpoint of their
+	///   scalar ranges: ranges entirely below or above go to the
+	///   children, and the ones containing the median stay in the node,
+	///   listed by ascending minimum and by descending maximum
+	/// @arg vol volume with vertices (scalar in w) and tetrahedra lists
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol);
+
+	/// @return true if the tree is built
+	bool valid(void) const { return nodes != NULL; }
+
+	/// Active cells
+	///   Lists the tets whose scalar range contains any of the values
+	///   (as hapt_iso.geom checks each tet), by walking each value down
+	///   one path of the tree (see subset)
+	/// @arg values iso-values
+	/// @arg n number of iso-values
+	void query(const GLfloat *values, GLuint n);
+
+	/// @return active tetrahedra (ascending ids)
+	const tetSubset& subset(void) const { return active; }
+	tetSubset& subset(void) { return active; }
+
+	/// @return number of tree nodes
+	GLuint numNodes(void) const { return nodeCount; }
+
+	/// Size of interval tree
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	intervalNode *nodes; ///< Tree nodes (root first)
+	GLuint nodeCount; ///< Number of nodes
+
+	GLuint *byMin; ///< Node tets by ascending scalar minimum
+	GLfloat *minValue; ///< Scalar minimum of each byMin entry
+
+	GLuint *byMax; ///< Node tets by descending scalar maximum
+	GLfloat *maxValue; ///< Scalar maximum of each byMax entry
+
+	tetSubset active; ///< Active tets
+
+};
+
+#endif
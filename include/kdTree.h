@@ -0,0 +1,88 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   kdTree : defines a class to build a k-d tree (axis-aligned BSP) over
+ *            the tetrahedra centroids and to order the tetrahedra by a
+ *            back-to-front traversal of the tree.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _KDTREE_H_
+#define _KDTREE_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+#include "centroidStore.h"
+
+/// Maximum number of tetrahedra in a leaf (sorted by centroid Z per frame)
+#define KD_LEAF_SIZE 512
+
+/// ----------------------------------   kdTree   ------------------------------------
+
+/// k-d Tree
+
+class kdTree {
+
+public:
+
+	/// Constructor
+	kdTree();
+
+	/// Destructor
+	~kdTree();
+
+	/// Build the tree
+	///   Each node splits its tets in two halves at the median centroid
+	///   of the longest axis, so the tree is balanced and stored as a
+	///   heap (children of node k are 2k+1 and 2k+2).  Straddling tets
+	///   go to the side of their centroid.  Nodes of the same level are
+	///   split in parallel
+	/// @arg c tetrahedra centroids
+	/// @return true if it succeed
+	bool build(const centroidStore& c);
+
+	/// @return true if the tree is built
+	bool valid(void) const { return perm != NULL; }
+
+	/// Size of k-d tree
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// Number of leaves
+	GLuint size(void) const { return numLeaves; }
+
+	/// Back-to-front order
+	///   The tree is traversed far child first (chosen by the view
+	///   direction), listing the leaves; then the leaves are sorted by
+	///   centroid Z in parallel, each one into its slice of ids
+	/// @arg ids output sorted ids (only written)
+	/// @arg c tetrahedra centroids
+	/// @arg mv column-major modelview matrix
+	void sort(GLuint *ids, const centroidStore& c, const GLfloat *mv);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	GLuint numLevels; ///< Number of levels of internal nodes
+
+	GLuint numLeaves; ///< Number of leaves
+
+	GLuint *perm; ///< Tets in tree order (each node is a contiguous range)
+
+	GLubyte *axis; ///< Split axis of each internal node (heap order)
+
+	GLuint *leafBegin, *leafEnd, *leafOut; ///< Leaves in traversal order: tree range and output offset
+
+};
+
+#endif
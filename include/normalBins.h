@@ -0,0 +1,107 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   normalBins : defines a class to group the interior faces of the
+ *                volume by normal direction (cube map bins on the sphere),
+ *                used to update the MPVO DAG only where it can change.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _NORMALBINS_H_
+#define _NORMALBINS_H_
+
+#include "appVol.h"
+
+/// Bins per cube face side: 6 x res^2 bins on the sphere
+#define NORMAL_BINS_RES 16
+
+/// Bin side of the view plane
+#define BIN_NEGATIVE -1 ///< all normals point against the view
+#define BIN_MIXED 0 ///< normals on both sides, faces are checked one by one
+#define BIN_POSITIVE 1 ///< all normals point along the view
+#define BIN_UNKNOWN 2 ///< no DAG direction computed for the bin faces
+
+/// ----------------------------------   normalBins   ------------------------------------
+
+/// Face Normal Bins
+
+class normalBins {
+
+public:
+
+	typedef appVol::vec3 vec3;
+
+	/// Constructor
+	normalBins();
+
+	/// Destructor
+	~normalBins();
+
+	/// Build the bins of the interior faces
+	///   Each face shared by two tets is stored once, from the lowest
+	///   tet id, as (tet id * 4 + face), binned by its normal
+	/// @arg vol volume with connectivity and face normals
+	/// @arg res bins per cube face side
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol, GLuint res = NORMAL_BINS_RES);
+
+	/// Size of normal bins
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// @return true if the bins are built
+	bool valid(void) const { return faces != NULL; }
+
+	/// Forget the bin states (after the DAG is changed elsewhere)
+	void invalidate(void);
+
+	/// Number of bins
+	GLuint size(void) const { return numBins; }
+
+	/// Number of binned (interior) faces
+	GLuint numFaces(void) const { return (numBins) ? binStart[numBins] : 0; }
+
+	/// Faces of a bin
+	/// @arg b bin index
+	const GLuint *binFaces(GLuint b) const { return faces + binStart[b]; }
+	GLuint binSize(GLuint b) const { return binStart[b + 1] - binStart[b]; }
+
+	/// Side of the view plane of all normals in a bin
+	/// @arg b bin index
+	/// @arg viewDir normalized view direction
+	/// @return BIN_POSITIVE, BIN_NEGATIVE or BIN_MIXED
+	GLint side(GLuint b, const vec3& viewDir) const {
+		GLfloat c = binCenter[b*3] * viewDir[0] + binCenter[b*3+1] * viewDir[1] + binCenter[b*3+2] * viewDir[2];
+		if( c > binSinRadius[b] ) return BIN_POSITIVE;
+		if( c < -binSinRadius[b] ) return BIN_NEGATIVE;
+		return BIN_MIXED;
+	}
+
+	/// Bin side used by the current DAG directions
+	GLint state(GLuint b) const { return binState[b]; }
+	void setState(GLuint b, GLint s) { binState[b] = s; }
+
+private:
+
+	GLuint numBins; ///< Number of bins
+
+	GLuint *binStart; ///< First face of each bin (numBins + 1)
+
+	GLuint *faces; ///< Binned faces (tet id * 4 + face)
+
+	GLfloat *binCenter; ///< Mean normal direction of each bin (numBins x 3)
+
+	GLfloat *binSinRadius; ///< Sine of the bin cone angle (plus a safety margin)
+
+	signed char *binState; ///< Bin side used by the current DAG (BIN_*)
+
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   orderCache : defines a class to precompute and store the back-to-front
+ *                centroid orders for a set of view directions (geodesic
+ *                sphere), used as starting orders to be repaired at runtime.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _ORDERCACHE_H_
+#define _ORDERCACHE_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+#include "centroidStore.h"
+
+/// Geodesic sphere subdivision level of the cached directions: the
+/// sphere has 10 * 4^level + 2 directions, only half of them are
+/// stored since opposite directions have reversed orders
+#define ORDER_CACHE_LEVEL 1
+
+/// ----------------------------------   orderCache   ------------------------------------
+
+/// View Direction Order Cache
+
+class orderCache {
+
+public:
+
+	typedef appVol::vec3 vec3;
+
+	/// Constructor
+	orderCache();
+
+	/// Destructor
+	~orderCache();
+
+	/// Build the orders of all directions of a geodesic sphere
+	///   Each order is one parallel radix sort of the centroids
+	/// @arg c tetrahedra centroids
+	/// @arg sorter CPU sort (initialized for c.size() elements)
+	/// @arg level geodesic sphere subdivision level
+	/// @return true if it succeed
+	bool build(const centroidStore& c, cpuSort& sorter, GLuint level = ORDER_CACHE_LEVEL);
+
+	/// Read the order cache (binary)
+	///   The header must match the volume and ORDER_CACHE_LEVEL, the
+	///   file size the header, and every order must be a permutation of
+	///   the tets; otherwise nothing is kept
+	/// @arg f file name
+	/// @arg numTets number of tetrahedra of the current volume
+	/// @return true if it succeed
+	bool read(const char* f, GLuint numTets);
+
+	/// Write the order cache (binary)
+	/// @arg f file name
+	/// @return true if it succeed
+	bool write(const char* f) const;
+
+	/// @return true if the orders are built or read
+	bool valid(void) const { return orders != NULL; }
+
+	/// Size of order cache
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// Number of stored directions
+	GLuint size(void) const { return numDirs; }
+
+	/// Copy the back-to-front order of the nearest cached direction
+	/// @arg ids output ids
+	/// @arg viewDir view direction (looking into the screen, object space)
+	/// @return stored direction index used
+	GLuint nearestOrder(GLuint *ids, const vec3& viewDir) const;
+
+	/// Number of stored directions of a geodesic sphere
+	/// @arg level subdivision level
+	/// @return half of the 10 * 4^level + 2 sphere vertices
+	static GLuint numDirections(GLuint level) { return 5 * (1 << (2 * level)) + 1; }
+
+private:
+
+	/// @return true if the directions are unit and every order is a
+	///         permutation of the tets
+	bool validOrders(void) const;
+
+	/// Free the orders and directions
+	void clear(void);
+
+	GLuint numTets; ///< Number of tetrahedra in each order
+
+	GLuint numDirs; ///< Number of stored directions
+
+	GLfloat *dirs; ///< Stored directions (numDirs x 3)
+
+	GLuint *orders; ///< Back-to-front orders (numDirs x numTets)
+
+};
+
+#endif
@@ -59,6 +59,9 @@ void glPTMotion(int x, int y);
 /// glPT animate function
 void glPTAnimate( int value );
 
+/// glPT pipeline function (redraws until the last sort is shown)
+void glPTPipeline( int value );
+
 /// glPT Application Setup
 extern
 void glPTSetup(void);
@@ -0,0 +1,75 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   quantizedCentroids : defines a class to store the tetrahedra
+ *                        centroids quantized to 16 bits per coordinate
+ *                        inside the volume bounding box (compact sort).
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _QUANTIZEDCENTROIDS_H_
+#define _QUANTIZEDCENTROIDS_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+/// Quantization levels of each centroid coordinate
+#define QUANT_LEVELS 65535
+
+/// ----------------------------------   quantizedCentroids   ------------------------------------
+
+/// Quantized Centroids
+
+class quantizedCentroids {
+
+public:
+
+	/// Constructor
+	quantizedCentroids();
+
+	/// Destructor
+	~quantizedCentroids();
+
+	/// Build the quantized centroid of each tetrahedron
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol);
+
+	/// Size of quantized centroids
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+	/// @return true if the centroids are built
+	bool valid(void) const { return qX != NULL; }
+
+	/// Number of centroids
+	GLuint size(void) const { return numCentroids; }
+
+	/// Packed depth keys of all centroids in one streaming pass
+	///   Each key is the depth mapped linearly from the bounding box
+	///   depth range to 32 bits (high word) and the centroid id (low
+	///   word), so ascending keys are back-to-front
+	/// @arg p output packed keys
+	/// @arg mv column-major matrix (modelview)
+	/// @arg row matrix row (default z -> r=2)
+	void packedKeys(uint_64 *p, const GLfloat *mv, GLuint row = 2) const;
+
+private:
+
+	GLuint numCentroids; ///< Number of centroids
+
+	GLushort *qX, *qY, *qZ; ///< Quantized centroid coordinates (SoA)
+
+	GLfloat origin[3], step[3]; ///< Bounding box origin and quantization step
+
+};
+
+#endif
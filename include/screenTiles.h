@@ -0,0 +1,129 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   screenTiles : defines a class for sort-first visibility sorting,
+ *                 the tetrahedra are binned in screen tiles by their
+ *                 projected bounding box and each tile list is sorted
+ *                 on its own (in parallel).
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _SCREENTILES_H_
+#define _SCREENTILES_H_
+
+#include "appVol.h"
+
+#include "cpuSort.h"
+
+/// Default screen tile size (in pixels)
+#define SORT_TILE 128
+
+/// Window coordinate of a vertex behind the eye (w <= 0, tet in all tiles)
+#define TILE_BEHIND 1.0e30
+
+/// ----------------------------------   screenTiles   ------------------------------------
+
+/// Screen Tiles
+
+class screenTiles {
+
+public:
+
+	/// Constructor
+	screenTiles();
+
+	/// Destructor
+	~screenTiles();
+
+	/// Set tile size (used by the next sort)
+	/// @arg _s tile size in pixels
+	void setTileSize(GLuint _s) { tileSize = (_s < 8) ? 8 : _s; }
+
+	/// @return tile size in pixels
+	GLuint getTileSize(void) const { return tileSize; }
+
+	/// Bin and sort the tetrahedra
+	///   Lists each tet in the tiles touched by the bounding box of its
+	///   projected vertices (none outside the viewport) and sorts each
+	///   tile list back-to-front by the depth keys (see order)
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @arg keys monotone depth key of each tet (ascending is back-to-front)
+	/// @arg mvp column-major modelview-projection matrix
+	/// @arg viewport viewport (x, y, width, height) as glGetIntegerv
+	/// @arg visible one flag per tet, only flagged tets are binned (NULL for all)
+	/// @return true if it succeed
+	bool sort(const offVol< GLfloat, GLuint >& vol, const GLuint *keys,
+		  const GLfloat *mvp, const GLint *viewport, const GLubyte *visible = NULL);
+
+	/// @return tile lists, each one back-to-front (size() ids)
+	const GLuint *order(void) const { return tileIds; }
+
+	/// @return number of ids in all tile lists
+	GLuint size(void) const { return (tileStart) ? tileStart[ numTiles() ] : 0; }
+
+	/// @return number of tiles
+	GLuint numTiles(void) const { return tilesX * tilesY; }
+
+	/// Tile list
+	/// @arg t tile
+	/// @return first id of the tile in order()
+	GLuint tileFirst(GLuint t) const { return tileStart[t]; }
+
+	/// @arg t tile
+	/// @return number of ids of the tile
+	GLuint tileCount(GLuint t) const { return tileStart[t+1] - tileStart[t]; }
+
+	/// Tile rectangle in window coordinates (as glScissor)
+	/// @arg t tile
+	/// @arg x, y, w, h returns the tile rectangle
+	void tileRect(GLuint t, GLint& x, GLint& y, GLsizei& w, GLsizei& h) const;
+
+	/// @return mean number of tiles per tetrahedron of the last sort
+	GLfloat overlap(void) const { return (numTets) ? size() / (GLfloat)numTets : 0.0; }
+
+	/// Size of screen tiles
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	/// Tiles touched by a tetrahedron
+	/// @arg vol volume with vertices and tetrahedra lists
+	/// @arg t tetrahedron
+	/// @arg tx0, ty0, tx1, ty1 returns the tile range (inclusive)
+	/// @return false if the tetrahedron is outside the viewport
+	bool tetBounds(const offVol< GLfloat, GLuint >& vol, GLuint t, GLint& tx0, GLint& ty0, GLint& tx1, GLint& ty1) const;
+
+	/// Resize the per-tile arrays (nothing done if the tiles are the same)
+	/// @return true if it succeed
+	bool resizeTiles(GLuint w, GLuint h);
+
+	GLuint tileSize; ///< Tile size in pixels
+
+	GLint view[4]; ///< Viewport of the last sort
+
+	GLuint tilesX, tilesY; ///< Number of tiles per axis
+
+	GLuint numTets; ///< Tetrahedra of the last sort
+
+	GLfloat *winVerts; ///< Window coordinates of the vertices (2 per vertex)
+	GLuint numWinVerts; ///< Vertices allocated
+
+	GLuint *tileStart; ///< Start of each tile list (numTiles + 1)
+
+	uint_64 *tileKeys; ///< Packed depth keys and ids of the tile lists
+	GLuint *tileIds; ///< Tile lists, back-to-front
+	GLuint tileListSize; ///< Tile lists allocated
+
+	GLuint *threadCount; ///< Tets per thread and tile (binning)
+
+};
+
+#endif
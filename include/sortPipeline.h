@@ -0,0 +1,117 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   sortPipeline : defines a class to sort the tetrahedra in a worker
+ *                  thread, for the latest requested view, while the
+ *                  OpenGL thread draws with the last completed order.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _SORTPIPELINE_H_
+#define _SORTPIPELINE_H_
+
+extern "C" {
+#include <GL/gl.h> // OpenGL library
+}
+
+#include <pthread.h> // POSIX threads
+
+/// Number of CPU order slots: one being written by the worker, one
+/// completed and one being read (uploaded) by the OpenGL thread
+#define NUM_SORT_SLOTS 3
+
+/// ----------------------------------   sortPipeline   ------------------------------------
+
+/// Sort Pipeline
+
+class sortPipeline {
+
+public:
+
+	/// Sort function called by the worker thread
+	/// @arg obj object given in start
+	/// @arg method sort method
+	/// @arg mv column-major modelview matrix of the request
+	/// @arg order output back-to-front ids
+	typedef void (*sortFunc)(void *obj, GLint method, const GLfloat *mv, GLuint *order);
+
+	/// Constructor
+	sortPipeline();
+
+	/// Destructor
+	~sortPipeline();
+
+	/// Allocate the order slots and start the worker thread
+	/// @arg _n number of ids in each order
+	/// @arg _f sort function
+	/// @arg _obj object passed to the sort function
+	/// @return true if it succeed
+	bool start(GLuint _n, sortFunc _f, void *_obj);
+
+	/// Stop the worker thread (waits for the current sort)
+	void stop(void);
+
+	/// @return true if the worker thread is running
+	bool running(void) const { return started; }
+
+	/// Request a sort: replaces any request not yet taken by the worker
+	/// @arg method sort method
+	/// @arg mv column-major modelview matrix
+	void request(GLint method, const GLfloat *mv);
+
+	/// Take the newest completed order, if any, for reading
+	/// @return order (valid until release) or NULL if none is new
+	const GLuint *acquire(void);
+
+	/// Give back the order taken by acquire
+	void release(void);
+
+	/// @return true if a request is pending, being sorted or not yet read
+	bool busy(void);
+
+	/// @return time of the last sort in the worker (in seconds)
+	GLdouble sortTime(void);
+
+	/// Size of sort pipeline
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	/// Worker thread loop
+	static void *run(void *_p);
+
+	GLuint n; ///< Number of ids in each order
+
+	sortFunc func; ///< Sort function
+
+	void *obj; ///< Sort function object
+
+	GLuint *slots[NUM_SORT_SLOTS]; ///< Order slots
+
+	GLint ready, reading; ///< Completed and being read slots (-1 if none)
+
+	bool pending, sorting, quit, started; ///< Worker state
+
+	GLint reqMethod; ///< Requested sort method
+
+	GLfloat reqMV[16]; ///< Requested modelview
+
+	GLdouble lastTime; ///< Last sort time
+
+	pthread_t thread; ///< Worker thread
+
+	pthread_mutex_t mutex; ///< Lock of the worker state
+
+	pthread_cond_t cond; ///< Signals a new request (or quit)
+
+};
+
+#endif
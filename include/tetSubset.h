@@ -0,0 +1,106 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   tetSubset : defines a class to keep a subset of the tetrahedra, as a
+ *               list of ids and one flag per tetrahedron, shared by the
+ *               indexes that restrict the tetrahedra sorted and drawn.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _TETSUBSET_H_
+#define _TETSUBSET_H_
+
+#include "cpuSort.h"
+
+/// ----------------------------------   tetSubset   ------------------------------------
+
+/// Tetrahedra Subset
+
+class tetSubset {
+
+public:
+
+	/// Constructor
+	tetSubset();
+
+	/// Destructor
+	~tetSubset();
+
+	/// Create an empty subset
+	/// @arg _numTets number of tetrahedra
+	/// @return true if it succeed
+	bool create(GLuint _numTets);
+
+	/// @return true if the subset is created
+	bool valid(void) const { return ids != NULL; }
+
+	/// List all tetrahedra (ascending)
+	void fill(void);
+
+	/// Empty the subset (clears only the flags of the listed tets)
+	void clear(void);
+
+	/// List the flagged tetrahedra (ascending, in parallel)
+	void compact(void);
+
+	/// Add a tetrahedron (once)
+	/// @arg t tetrahedron id
+	void add(GLuint t) {
+		if( flag[t] ) return;
+		flag[t] = 1;
+		ids[ count++ ] = t;
+	}
+
+	/// Set a list entry and flag its tetrahedron (listing in parallel,
+	/// see resize)
+	/// @arg k list position
+	/// @arg t tetrahedron id
+	void set(GLuint k, GLuint t) { ids[k] = t; flag[t] = 1; }
+
+	/// @arg n number of tetrahedra listed by set
+	void resize(GLuint n) { count = n; }
+
+	/// @return tetrahedra ids
+	const GLuint *list(void) const { return ids; }
+	GLuint *list(void) { return ids; }
+
+	/// @return number of tetrahedra
+	GLuint size(void) const { return count; }
+
+	/// @return one flag per tetrahedron (non-zero if in the subset)
+	const GLubyte *flags(void) const { return flag; }
+	GLubyte *flags(void) { return flag; }
+
+	/// Keep only the tetrahedra of the subset in an order (in place)
+	/// @arg order tetrahedra ids (input and output)
+	/// @arg n number of ids
+	/// @return number of ids kept (in the same order)
+	GLuint filter(GLuint *order, GLuint n);
+
+	/// Size of subset data
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	GLubyte *flag; ///< Flag of each tet
+
+	GLuint *ids; ///< Tets in the subset
+	GLuint count; ///< Number of tets in the subset
+
+	GLuint *filterIds; ///< Filter output (allocated on first use)
+
+	GLuint *threadCount; ///< Tets per thread (compaction)
+
+};
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   tfCulling : defines a class to cull the tetrahedra with no opacity
+ *               under the transfer function, keeping a compact list of
+ *               the visible tetrahedra to be sorted and drawn.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _TFCULLING_H_
+#define _TFCULLING_H_
+
+#include "appVol.h"
+
+#include "tetSubset.h"
+
+/// Quantization levels of the tetrahedra scalar ranges
+#define CULL_LEVELS 65535
+
+/// ----------------------------------   tfCulling   ------------------------------------
+
+/// Transfer Function Culling
+
+class tfCulling {
+
+public:
+
+	/// Constructor
+	tfCulling();
+
+	/// Destructor
+	~tfCulling();
+
+	/// Build the scalar range of each tetrahedron
+	///   Ranges are quantized to 16 bits, rounded outwards
+	/// @arg vol volume with vertices (scalar in w) and tetrahedra lists
+	/// @return true if it succeed
+	bool build(const offVol< GLfloat, GLuint >& vol);
+
+	/// Update the visible list for the current transfer function
+	///   A prefix table of the transfer function entries with opacity
+	///   tells in O(1) if the entries of a tet scalar range are all
+	///   transparent, and the visible tets are compacted in parallel
+	/// @arg vol volume with the transfer function
+	/// @return true if it succeed
+	bool update(const offVol< GLfloat, GLuint >& vol);
+
+	/// @return true if the scalar ranges are built
+	bool valid(void) const { return range != NULL; }
+
+	/// @return visible tetrahedra (ascending ids)
+	const tetSubset& subset(void) const { return visible; }
+	tetSubset& subset(void) { return visible; }
+
+	/// Size of culling data
+	/// @return memory usage in Bytes
+	size_t sizeOf(void);
+
+private:
+
+	GLuint numTets; ///< Number of tetrahedra
+
+	GLushort *range; ///< Quantized scalar minimum and maximum of each tet
+
+	GLuint *opacityPrefix; ///< Transfer function entries with opacity before each entry
+	GLuint numColors; ///< Transfer function size
+
+	tetSubset visible; ///< Visible tets
+
+};
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   visibilitySorter : defines the interface of the visibility sorters
+ *                      (back-to-front ordering of the tetrahedra) and
+ *                      the registry listing them for the renderer, the
+ *                      key bindings and the information overlay.
+ *
+ * C++ header.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#ifndef _VISIBILITYSORTER_H_
+#define _VISIBILITYSORTER_H_
+
+#include "appVol.h"
+
+#include "centroidStore.h"
+
+/// Maximum number of sorters: built-in sort methods and plug-ins
+#define MAX_SORTERS 32
+
+/// ----------------------------------   visibilitySorter   ------------------------------------
+
+/// Visibility Sorter
+
+class visibilitySorter {
+
+public:
+
+	/// Constructor
+	/// @arg _name name shown in the information box
+	/// @arg _key key binding (0 if none)
+	visibilitySorter(const char *_name, char _key = 0);
+
+	/// Destructor
+	virtual ~visibilitySorter();
+
+	/// Prepare the sorter for a volume (called once, after the centroids
+	/// are built and before any sort)
+	/// @arg vol volume with connectivity and face normals
+	/// @arg c tetrahedra centroids
+	/// @return true if it succeed
+	virtual bool init(const offVol< GLfloat, GLuint >& vol, const centroidStore& c) = 0;
+
+	/// Back-to-front order for a view
+	/// @arg ids output sorted ids (numTets, only written)
+	/// @arg mv column-major modelview matrix
+	virtual void sort(GLuint *ids, const GLfloat *mv) = 0;
+
+	/// Size of sorter data
+	/// @return memory usage in Bytes
+	virtual size_t sizeOf(void) { return 0; }
+
+	/// @return name shown in the information box
+	virtual const char *name(void) const { return sorterName; }
+
+	/// @return key binding (0 if none)
+	char key(void) const { return sorterKey; }
+
+	/// Sort and time it
+	/// @arg ids output sorted ids
+	/// @arg mv column-major modelview matrix
+	void run(GLuint *ids, const GLfloat *mv);
+
+	/// Timing statistics of run
+	GLdouble lastTime(void) const { return last; } ///< (in seconds)
+	GLdouble meanTime(void) const { return (runs) ? total / runs : 0.0; } ///< (in seconds)
+	GLuint numRuns(void) const { return runs; }
+	void resetStats(void) { last = total = 0.0; runs = 0; }
+
+private:
+
+	const char *sorterName; ///< Sorter name
+
+	char sorterKey; ///< Key binding
+
+	GLdouble last, total; ///< Last and accumulated sort times
+
+	GLuint runs; ///< Number of timed sorts
+
+};
+
+/// ----------------------------------   sorterRegistry   ------------------------------------
+
+/// Sorter Registry
+
+class sorterRegistry {
+
+public:
+
+	/// Plug-in factory (see REGISTER_SORTER)
+	typedef visibilitySorter *(*sorterFactory)(void);
+
+	/// Constructor
+	sorterRegistry();
+
+	/// Destructor (deletes the registered sorters)
+	~sorterRegistry();
+
+	/// Add a sorter (the registry owns it)
+	/// @arg s sorter
+	/// @arg id sorter id, or the first free id after the used ones if -1
+	/// @return sorter id, or -1 if the registry is full
+	GLint add(visibilitySorter *s, GLint id = -1);
+
+	/// Add one instance of each plug-in sorter
+	/// @return number of plug-ins added
+	GLuint addPlugins(void);
+
+	/// Initialize all sorters, removing the ones that fail
+	/// @arg vol volume with connectivity and face normals
+	/// @arg c tetrahedra centroids
+	/// @return number of sorters initialized
+	GLuint init(const offVol< GLfloat, GLuint >& vol, const centroidStore& c);
+
+	/// Delete all sorters
+	void clear(void);
+
+	/// @return one past the last sorter id
+	GLuint size(void) const { return count; }
+
+	/// Sorter of an id
+	/// @arg id sorter id
+	/// @return sorter or NULL if none
+	visibilitySorter *get(GLint id) const { return ( id >= 0 && id < (GLint)count ) ? sorters[id] : NULL; }
+
+	/// Sorter bound to a key (case insensitive)
+	/// @arg k key
+	/// @return sorter id or -1 if none
+	GLint findKey(char k) const;
+
+	/// Sorter with a name
+	/// @arg n name
+	/// @return sorter id or -1 if none
+	GLint findName(const char *n) const;
+
+	/// Size of sorter registry (and sorters data)
+	/// @arg first first sorter id counted (the data of the ones
+	///      before is counted by their owner)
+	/// @return memory usage in Bytes
+	size_t sizeOf(GLuint first = 0);
+
+	/// Register a plug-in sorter factory (at static initialization)
+	/// @arg f factory
+	/// @return true if it succeed
+	static bool registerPlugin(sorterFactory f);
+
+private:
+
+	visibilitySorter *sorters[MAX_SORTERS]; ///< Sorters by id (NULL if none)
+
+	GLuint count; ///< One past the last sorter id
+
+	static sorterFactory plugins[MAX_SORTERS]; ///< Plug-in factories
+
+	static GLuint numPlugins; ///< Number of plug-in factories
+
+};
+
+/// Register a plug-in sorter class (default constructible), in its .cc:
+///   REGISTER_SORTER(mySorter)
+/// Plug-ins get the ids after the built-in sort methods
+#define REGISTER_SORTER(cls) \
+	static visibilitySorter *cls##Factory(void) { return new cls; } \
+	static bool cls##Registered = sorterRegistry::registerPlugin( cls##Factory );
+
+#endif
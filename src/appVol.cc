@@ -47,6 +47,7 @@ appVol::appVol( bool _d ) : volume(), debug(_d) {
 	lmtExt = string(".lmt");
 	conExt = string(".con");
 	isoExt = string(".iso");
+	ordExt = string(".ord");
 	searchDir = string("tet_offs/");
 
 }
@@ -77,6 +78,7 @@ bool appVol::setup(int& argc, char** argv) {
 			<< "  |_ (-) 'file'" << tfExt << " : transfer function with 256 colors" << endl
 			<< "  |_ (-) 'file'" << lmtExt << " : volume limits with maxEdgeLength, maxZ and minZ " << endl
 			<< "  |_ (-) 'file'" << conExt << " : volume connectivity " << endl
+			<< "  |_ (-) 'file'" << ordExt << " : view-direction order cache (only with the cached sort) " << endl
 			<< "  Reading from the directory: " << searchDir << endl
 			<< "  Files marked by (x) need to exist." << endl
 			<< "  If the files marked by (-) does not exist, it will be computed and created.\n";
@@ -0,0 +1,199 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   brickGrid : defines a class to partition the tetrahedra in spatial
+ *               bricks (uniform grid over the centroids) and to sort them
+ *               in two levels: bricks by depth, then tets inside bricks.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "brickGrid.h"
+
+#include <algorithm>
+
+/// ----------------------------------   brickGrid   ------------------------------------
+
+/// Constructor
+brickGrid::brickGrid() :
+	numTets(0), numBricks(0),
+	brickStart(NULL), brickTets(NULL), brickCenter(NULL),
+	brickOrder(NULL), brickOut(NULL) {
+
+}
+
+/// Destructor
+brickGrid::~brickGrid() {
+
+	if( brickStart ) delete [] brickStart;
+	if( brickTets ) delete [] brickTets;
+	if( brickCenter ) delete [] brickCenter;
+	if( brickOrder ) delete [] brickOrder;
+	if( brickOut ) delete [] brickOut;
+
+}
+
+/// Build bricks
+bool brickGrid::build(const centroidStore& c, GLuint res) {
+
+	numTets = c.size();
+
+	if( numTets == 0 ) return false;
+
+	/// Centroids bounding box
+	GLfloat lo[3] = { c.x(0), c.y(0), c.z(0) }, hi[3] = { lo[0], lo[1], lo[2] };
+
+	for (GLuint i = 1; i < numTets; ++i) {
+		GLfloat p[3] = { c.x(i), c.y(i), c.z(i) };
+		for (GLuint k = 0; k < 3; ++k) {
+			if( p[k] < lo[k] ) lo[k] = p[k];
+			if( p[k] > hi[k] ) hi[k] = p[k];
+		}
+	}
+
+	GLfloat scale[3];
+	for (GLuint k = 0; k < 3; ++k)
+		scale[k] = ( hi[k] > lo[k] ) ? res / (hi[k] - lo[k]) : 0.0;
+
+	GLuint gridSize = res * res * res;
+
+	/// Grid cell of each tet (kept in brickTets until the counting sort)
+	if( brickTets ) delete [] brickTets;
+	brickTets = new GLuint[ numTets ];
+	if( !brickTets ) return false;
+
+	GLuint *cell = new GLuint[ numTets ];
+	GLuint *cellCount = new GLuint[ gridSize + 1 ];
+	if( !cell || !cellCount ) return false;
+
+	memset( cellCount, 0, (gridSize + 1) * sizeof(GLuint) );
+
+	for (GLuint i = 0; i < numTets; ++i) {
+
+		GLfloat p[3] = { c.x(i), c.y(i), c.z(i) };
+		GLuint g[3];
+
+		for (GLuint k = 0; k < 3; ++k) {
+			g[k] = (GLuint)( (p[k] - lo[k]) * scale[k] );
+			if( g[k] >= res ) g[k] = res - 1;
+		}
+
+		cell[i] = ( g[0] * res + g[1] ) * res + g[2];
+		cellCount[ cell[i] + 1 ]++;
+
+	}
+
+	/// Non-empty bricks
+	numBricks = 0;
+	for (GLuint g = 0; g < gridSize; ++g)
+		if( cellCount[g + 1] ) ++numBricks;
+
+	if( brickStart ) delete [] brickStart;
+	brickStart = new GLuint[ numBricks + 1 ];
+	if( !brickStart ) return false;
+
+	if( brickCenter ) delete [] brickCenter;
+	brickCenter = new GLfloat[ numBricks * 3 ];
+	if( !brickCenter ) return false;
+
+	if( brickOrder ) delete [] brickOrder;
+	brickOrder = new tetCentroid[ numBricks ];
+	if( !brickOrder ) return false;
+
+	if( brickOut ) delete [] brickOut;
+	brickOut = new GLuint[ numBricks ];
+	if( !brickOut ) return false;
+
+	/// Cell offsets and brick centers
+	GLuint b = 0;
+	brickStart[0] = 0;
+
+	for (GLuint g = 0; g < gridSize; ++g) {
+
+		cellCount[g + 1] += cellCount[g];
+
+		if( cellCount[g + 1] == cellCount[g] ) continue;
+
+		brickStart[b + 1] = cellCount[g + 1];
+
+		/// Brick center
+		GLuint gx = g / (res * res), gy = (g / res) % res, gz = g % res;
+		brickCenter[b*3 + 0] = lo[0] + ( (scale[0] > 0.0) ? (gx + 0.5) / scale[0] : 0.0 );
+		brickCenter[b*3 + 1] = lo[1] + ( (scale[1] > 0.0) ? (gy + 0.5) / scale[1] : 0.0 );
+		brickCenter[b*3 + 2] = lo[2] + ( (scale[2] > 0.0) ? (gz + 0.5) / scale[2] : 0.0 );
+
+		++b;
+
+	}
+
+	/// Counting sort of the tets by brick
+	for (GLuint i = 0; i < numTets; ++i)
+		brickTets[ cellCount[ cell[i] ]++ ] = i;
+
+	delete [] cell;
+	delete [] cellCount;
+
+	return true;
+
+}
+
+/// Size of brick grid
+size_t brickGrid::sizeOf(void) {
+
+	return ( ( (brickTets) ? numTets * sizeof(GLuint) : 0 ) + ///< Tets brick by brick
+		 ( (brickStart) ? (numBricks + 1) * sizeof(GLuint) : 0 ) + ///< Brick offsets
+		 ( (brickCenter) ? numBricks * 3 * sizeof(GLfloat) : 0 ) + ///< Brick centers
+		 ( (brickOrder) ? numBricks * sizeof(tetCentroid) : 0 ) + ///< Brick order
+		 ( (brickOut) ? numBricks * sizeof(GLuint) : 0 ) + ///< Brick output offsets
+		 ( 2 * sizeof(GLuint) ) + ///< numTets, numBricks
+		 ( 5 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Two-level sort
+void brickGrid::sort(GLuint *ids, tetCentroid *scratch, const centroidStore& c, const GLfloat *mv) {
+
+	/// First level: bricks by center Z (apply ModelView Matrix mv, z -> r=2)
+	for (GLuint b = 0; b < numBricks; ++b) {
+		brickOrder[b].id = b;
+		brickOrder[b].cZ = mv[2] * brickCenter[b*3] + mv[6] * brickCenter[b*3+1]
+			+ mv[10] * brickCenter[b*3+2] + mv[14];
+	}
+
+	std::sort( brickOrder, brickOrder + numBricks );
+
+	GLuint out = 0;
+
+	for (GLuint k = 0; k < numBricks; ++k) {
+		GLuint b = brickOrder[k].id;
+		brickOut[b] = out;
+		out += brickStart[b + 1] - brickStart[b];
+	}
+
+	/// Second level: tets of each brick, in its own slice of ids
+#pragma omp parallel for schedule(dynamic, 4)
+	for (GLint b = 0; b < (GLint)numBricks; ++b) {
+
+		tetCentroid *brick = scratch + brickOut[b];
+		GLuint size = brickStart[b + 1] - brickStart[b];
+
+		for (GLuint i = 0; i < size; ++i) {
+			brick[i].id = brickTets[ brickStart[b] + i ];
+			brick[i].cZ = c.depth( brick[i].id, mv );
+		}
+
+		std::sort( brick, brick + size );
+
+		for (GLuint i = 0; i < size; ++i)
+			ids[ brickOut[b] + i ] = brick[i].id;
+
+	}
+
+}
@@ -0,0 +1,249 @@
+/**
+ *   HAPT -- Centroid CPU
+ *
+ *   CPU implementation of the centroid.cuh interface, compiled
+ *   instead of centroid.cu when CUDA is not available.  It keeps
+ *   the same packed 64-bit (depth | id) keys and runs the bitonic
+ *   and quick sorts on the OpenMP threads.
+ *
+ */
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "cpuSort.h"
+
+#include "centroid.cuh"
+
+typedef unsigned long long int uint_64;
+
+/// Maximum key, padding the bitonic array up to a power of two
+#define PACK_MAX 0xFFFFFFFFFFFFFFFFULL
+
+/// Minimum number of elements per bitonic step thread
+#define MIN_BITONIC_STEP 8192
+
+/// Quick sort partitions smaller than this are sorted by one thread
+#define QUICK_CUTOFF 16384
+
+static uint numCentroids = 0;
+
+static uint pofElements = 0; ///< Power of two above numCentroids
+
+static float *h_centroidX = NULL, *h_centroidY = NULL, *h_centroidZ = NULL; ///< Centroids (SoA)
+
+static uint_64 *packedArrayBitonic = NULL, *packedArrayQuick = NULL;
+
+/// Update centroid values (same quantization as the GPU kernel)
+
+static void updateCentroid( uint_64 *packedArray,
+			    const float mvX, const float mvY, const float mvZ,
+			    const uint nC ) {
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nC; ++i) {
+
+		float cZ = mvX * h_centroidX[i] + mvY * h_centroidY[i] + mvZ * h_centroidZ[i];
+
+		if( cZ < -1.0 ) cZ = -1.0;
+		if( cZ >  1.0 ) cZ =  1.0;
+
+		uint_64 pack = (uint_64)( ((cZ + 1.0) / 2.0) * 0xFFFFFFFF );
+		pack <<= 32;
+		pack += (uint_64) i;
+
+		packedArray[i] = pack;
+
+	}
+
+}
+
+/// Unpack array packed in update step
+
+static void unpackArray( uint *unpackedArray, const uint_64 *packedArray, const uint nC ) {
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nC; ++i)
+		unpackedArray[i] = (uint) ( packedArray[i] );
+
+}
+
+/// Bitonic sort of pofElements keys
+///   Each compare-exchange step of the sorting network is one
+///   parallel loop over the pairs (i, i xor j)
+
+static void bitonicSort( void ) {
+
+	GLint n = pofElements;
+
+	for (GLint k = 2; k <= n; k <<= 1) {
+
+		for (GLint j = k >> 1; j > 0; j >>= 1) {
+
+#pragma omp parallel for if( n >= MIN_BITONIC_STEP )
+			for (GLint i = 0; i < n; ++i) {
+
+				GLint ixj = i ^ j;
+
+				if( ixj <= i ) continue;
+
+				uint_64 a = packedArrayBitonic[i], b = packedArrayBitonic[ixj];
+
+				if( ( (i & k) == 0 ) ? (a > b) : (a < b) ) {
+					packedArrayBitonic[i] = b;
+					packedArrayBitonic[ixj] = a;
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+/// Quick sort partition [a, b) around the median of three keys
+///   Large partitions are split in OpenMP tasks
+
+static void quickSortTask( uint_64 *v, GLint a, GLint b ) {
+
+	while( b - a > QUICK_CUTOFF ) {
+
+		uint_64 x = v[a], y = v[a + (b - a) / 2], z = v[b - 1];
+		uint_64 pivot = std::max( std::min(x, y), std::min( std::max(x, y), z ) );
+
+		GLint i = a, j = b - 1;
+
+		while( i <= j ) {
+			while( v[i] < pivot ) ++i;
+			while( v[j] > pivot ) --j;
+			if( i <= j ) std::swap( v[i++], v[j--] );
+		}
+
+		/// Hand the smaller side to another thread, keep the larger one
+		if( j + 1 - a < b - i ) {
+#pragma omp task firstprivate(v, a, j)
+			quickSortTask( v, a, j + 1 );
+			a = i;
+		} else {
+#pragma omp task firstprivate(v, i, b)
+			quickSortTask( v, i, b );
+			b = j + 1;
+		}
+
+	}
+
+	std::sort( v + a, v + b );
+
+}
+
+static void quickSort( void ) {
+
+#pragma omp parallel
+	{
+#pragma omp single nowait
+		quickSortTask( packedArrayQuick, 0, numCentroids );
+	}
+
+}
+
+/// Number of devices (the CPU)
+
+extern "C"
+int numDevicesCUDA( void ) {
+
+	return 1;
+
+}
+
+/// Initialize General
+
+extern "C"
+void initCUDA( const float *_centroidX, const float *_centroidY,
+	       const float *_centroidZ, uint _numCentroids ) {
+
+	cleanCUDA();
+
+	numCentroids = _numCentroids;
+
+	for (pofElements = 1; pofElements < numCentroids; pofElements <<= 1) ;
+
+	h_centroidX = new float[ numCentroids ];
+	h_centroidY = new float[ numCentroids ];
+	h_centroidZ = new float[ numCentroids ];
+
+	memcpy( h_centroidX, _centroidX, numCentroids * sizeof(float) );
+	memcpy( h_centroidY, _centroidY, numCentroids * sizeof(float) );
+	memcpy( h_centroidZ, _centroidZ, numCentroids * sizeof(float) );
+
+	packedArrayBitonic = new uint_64[ pofElements ];
+	packedArrayQuick = new uint_64[ numCentroids ];
+
+	/// Padding keys stay at the end of the bitonic array
+	for (uint i = numCentroids; i < pofElements; ++i)
+		packedArrayBitonic[i] = PACK_MAX;
+
+}
+
+/// Run bitonic sort on CPU
+
+extern "C"
+void bitonicSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
+
+	updateCentroid( packedArrayBitonic, _mvX, _mvY, _mvZ, numCentroids );
+
+	/// The sort moves the padding keys around, restore them
+	for (uint i = numCentroids; i < pofElements; ++i)
+		packedArrayBitonic[i] = PACK_MAX;
+
+	bitonicSort();
+
+	unpackArray( ids, packedArrayBitonic, numCentroids );
+
+}
+
+/// Run quick sort on CPU
+
+extern "C"
+void quickSortCUDA( uint *ids, float _mvX, float _mvY, float _mvZ ) {
+
+	updateCentroid( packedArrayQuick, _mvX, _mvY, _mvZ, numCentroids );
+
+	quickSort();
+
+	unpackArray( ids, packedArrayQuick, numCentroids );
+
+}
+
+/// Size of the CPU arrays
+
+extern "C"
+unsigned long long sizeOfCUDA( void ) {
+
+	return ( ( (h_centroidX) ? 3ULL * numCentroids * sizeof(float) : 0 ) + ///< Centroids copy (SoA)
+		 ( (packedArrayBitonic) ? (unsigned long long)pofElements * sizeof(uint_64) : 0 ) + ///< Bitonic keys (power of two)
+		 ( (packedArrayQuick) ? (unsigned long long)numCentroids * sizeof(uint_64) : 0 ) ///< Quick sort keys
+		);
+
+}
+
+/// Clean CPU memory
+
+extern "C"
+void cleanCUDA( void ) {
+
+	if( h_centroidX ) delete [] h_centroidX;
+	if( h_centroidY ) delete [] h_centroidY;
+	if( h_centroidZ ) delete [] h_centroidZ;
+
+	if( packedArrayBitonic ) delete [] packedArrayBitonic;
+	if( packedArrayQuick ) delete [] packedArrayQuick;
+
+	h_centroidX = h_centroidY = h_centroidZ = NULL;
+	packedArrayBitonic = packedArrayQuick = NULL;
+
+	numCentroids = pofElements = 0;
+
+}
@@ -0,0 +1,374 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   centroidStore : defines a class to store the tetrahedra centroids in
+ *                   structure-of-arrays (SoA) layout and to compute their
+ *                   depth using SIMD instructions (AVX-512, AVX2 or portable).
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "centroidStore.h"
+
+#include <algorithm>
+
+/// The SIMD paths use fused multiply-adds as centroidStore::rowDot (the
+/// AVX2 path needs FMA, without it all centroids take the portable path)
+#if defined(__AVX2__) && defined(__FMA__)
+#define CENTROID_AVX2
+#endif
+
+#if defined(__AVX512F__) || defined(CENTROID_AVX2)
+#include <immintrin.h> // SIMD intrinsics
+#endif
+
+/// Number of floats computed per SIMD instruction
+#if defined(__AVX512F__)
+#define SIMD_WIDTH 16
+#elif defined(CENTROID_AVX2)
+#define SIMD_WIDTH 8
+#else
+#define SIMD_WIDTH 1
+#endif
+
+/// Number of centroids per thread block (multiple of SIMD_WIDTH)
+#define DEPTH_BLOCK 8192
+
+/// ----------------------------------   centroidStore   ------------------------------------
+
+/// Constructor
+centroidStore::centroidStore() :
+	numCentroids(0),
+	cX(NULL), cY(NULL), cZ(NULL) {
+
+}
+
+/// Destructor
+centroidStore::~centroidStore() {
+
+	if( cX ) delete [] cX;
+	if( cY ) delete [] cY;
+	if( cZ ) delete [] cZ;
+
+}
+
+/// Build centroids
+bool centroidStore::build(const offVol< GLfloat, GLuint >& vol) {
+
+	numCentroids = vol.numTets;
+
+	if( cX ) delete [] cX;
+	cX = new GLfloat[ numCentroids ];
+	if( !cX ) return false;
+
+	if( cY ) delete [] cY;
+	cY = new GLfloat[ numCentroids ];
+	if( !cY ) return false;
+
+	if( cZ ) delete [] cZ;
+	cZ = new GLfloat[ numCentroids ];
+	if( !cZ ) return false;
+
+	/// Compute the centroid of each tetrahedron
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numCentroids; ++i) {
+
+		appVol::vec3 c = ( vol.vertList[ vol.tetList[i][0] ].xyz()
+				   + vol.vertList[ vol.tetList[i][1] ].xyz()
+				   + vol.vertList[ vol.tetList[i][2] ].xyz()
+				   + vol.vertList[ vol.tetList[i][3] ].xyz() ) / 4.0;
+
+		cX[i] = c.x();
+		cY[i] = c.y();
+		cZ[i] = c.z();
+
+	}
+
+	return true;
+
+}
+
+/// Size of centroid store
+size_t centroidStore::sizeOf(void) {
+
+	return ( ( (size_t)3 * numCentroids * sizeof(GLfloat) ) + ///< Centroids (SoA)
+		 ( sizeof(GLuint) ) + ///< numCentroids
+		 ( 3 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Depths of all centroids
+void centroidStore::depths(GLfloat *d, const GLfloat *mv, GLuint stride, GLuint row) const {
+
+	const GLint numBlocks = (numCentroids + DEPTH_BLOCK - 1) / DEPTH_BLOCK;
+
+#pragma omp parallel for
+	for (GLint b = 0; b < numBlocks; ++b) {
+
+		GLuint i = b * DEPTH_BLOCK, end = i + DEPTH_BLOCK;
+		if( end > numCentroids ) end = numCentroids;
+
+#if SIMD_WIDTH > 1
+		GLfloat tmp[SIMD_WIDTH];
+#endif
+
+#if defined(__AVX512F__)
+		__m512 r0 = _mm512_set1_ps(mv[row]), r1 = _mm512_set1_ps(mv[row+4]),
+			r2 = _mm512_set1_ps(mv[row+8]), r3 = _mm512_set1_ps(mv[row+12]);
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m512 v = _mm512_fmadd_ps( r0, _mm512_loadu_ps(cX + i),
+						    _mm512_fmadd_ps( r1, _mm512_loadu_ps(cY + i),
+								     _mm512_fmadd_ps( r2, _mm512_loadu_ps(cZ + i), r3 ) ) );
+
+			if( stride == 1 ) _mm512_storeu_ps( d + i, v );
+			else {
+				_mm512_storeu_ps( tmp, v );
+				for (GLuint k = 0; k < SIMD_WIDTH; ++k) d[ (i+k) * stride ] = tmp[k];
+			}
+
+		}
+#elif defined(CENTROID_AVX2)
+		__m256 r0 = _mm256_set1_ps(mv[row]), r1 = _mm256_set1_ps(mv[row+4]),
+			r2 = _mm256_set1_ps(mv[row+8]), r3 = _mm256_set1_ps(mv[row+12]);
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m256 v = _mm256_fmadd_ps( r0, _mm256_loadu_ps(cX + i),
+						    _mm256_fmadd_ps( r1, _mm256_loadu_ps(cY + i),
+								     _mm256_fmadd_ps( r2, _mm256_loadu_ps(cZ + i), r3 ) ) );
+
+			if( stride == 1 ) _mm256_storeu_ps( d + i, v );
+			else {
+				_mm256_storeu_ps( tmp, v );
+				for (GLuint k = 0; k < SIMD_WIDTH; ++k) d[ (i+k) * stride ] = tmp[k];
+			}
+
+		}
+#endif
+
+		/// Portable path (and remaining centroids)
+		for (; i < end; ++i)
+			d[ i * stride ] = rowDot( mv + row, cX[i], cY[i], cZ[i] );
+
+	}
+
+}
+
+/// Depth keys of all centroids
+void centroidStore::keys(GLuint *k, const GLfloat *mv, GLuint row) const {
+
+	const GLint numBlocks = (numCentroids + DEPTH_BLOCK - 1) / DEPTH_BLOCK;
+
+#pragma omp parallel for
+	for (GLint b = 0; b < numBlocks; ++b) {
+
+		GLuint i = b * DEPTH_BLOCK, end = i + DEPTH_BLOCK;
+		if( end > numCentroids ) end = numCentroids;
+
+#if defined(__AVX512F__)
+		__m512 r0 = _mm512_set1_ps(mv[row]), r1 = _mm512_set1_ps(mv[row+4]),
+			r2 = _mm512_set1_ps(mv[row+8]), r3 = _mm512_set1_ps(mv[row+12]);
+		__m512i signBit = _mm512_set1_epi32(0x80000000), allBits = _mm512_set1_epi32(-1),
+			zeroBits = _mm512_setzero_si512();
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m512i u = _mm512_castps_si512(
+				_mm512_fmadd_ps( r0, _mm512_loadu_ps(cX + i),
+						 _mm512_fmadd_ps( r1, _mm512_loadu_ps(cY + i),
+								  _mm512_fmadd_ps( r2, _mm512_loadu_ps(cZ + i), r3 ) ) ) );
+
+			/// Negative: flip all bits; positive: flip the sign bit
+			__m512i flip = _mm512_mask_mov_epi32( signBit, _mm512_cmplt_epi32_mask(u, zeroBits), allBits );
+
+			_mm512_storeu_si512( (void*)(k + i), _mm512_xor_si512(u, flip) );
+
+		}
+#elif defined(CENTROID_AVX2)
+		__m256 r0 = _mm256_set1_ps(mv[row]), r1 = _mm256_set1_ps(mv[row+4]),
+			r2 = _mm256_set1_ps(mv[row+8]), r3 = _mm256_set1_ps(mv[row+12]);
+		__m256i signBit = _mm256_set1_epi32(0x80000000);
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m256i u = _mm256_castps_si256(
+				_mm256_fmadd_ps( r0, _mm256_loadu_ps(cX + i),
+						 _mm256_fmadd_ps( r1, _mm256_loadu_ps(cY + i),
+								  _mm256_fmadd_ps( r2, _mm256_loadu_ps(cZ + i), r3 ) ) ) );
+
+			/// Negative: flip all bits; positive: flip the sign bit
+			__m256i flip = _mm256_or_si256( _mm256_srai_epi32(u, 31), signBit );
+
+			_mm256_storeu_si256( (__m256i*)(k + i), _mm256_xor_si256(u, flip) );
+
+		}
+#endif
+
+		/// Portable path (and remaining centroids)
+		for (; i < end; ++i)
+			k[i] = cpuSort::floatKey( rowDot( mv + row, cX[i], cY[i], cZ[i] ) );
+
+	}
+
+}
+
+/// Depth keys following a given order
+void centroidStore::keys(GLuint *k, const GLuint *order, GLuint n, const GLfloat *mv, GLuint row) const {
+
+	const GLint numBlocks = (n + DEPTH_BLOCK - 1) / DEPTH_BLOCK;
+
+#pragma omp parallel for
+	for (GLint b = 0; b < numBlocks; ++b) {
+
+		GLuint i = b * DEPTH_BLOCK, end = i + DEPTH_BLOCK;
+		if( end > n ) end = n;
+
+#if defined(__AVX512F__)
+		__m512 r0 = _mm512_set1_ps(mv[row]), r1 = _mm512_set1_ps(mv[row+4]),
+			r2 = _mm512_set1_ps(mv[row+8]), r3 = _mm512_set1_ps(mv[row+12]);
+		__m512i signBit = _mm512_set1_epi32(0x80000000), allBits = _mm512_set1_epi32(-1),
+			zeroBits = _mm512_setzero_si512();
+		__m512 zero = _mm512_setzero_ps(); ///< Gather source (all lanes loaded)
+		const __mmask16 all = 0xFFFF;
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m512i id = _mm512_loadu_si512( (const void*)(order + i) );
+
+			__m512i u = _mm512_castps_si512(
+				_mm512_fmadd_ps( r0, _mm512_mask_i32gather_ps(zero, all, id, cX, 4),
+						 _mm512_fmadd_ps( r1, _mm512_mask_i32gather_ps(zero, all, id, cY, 4),
+								  _mm512_fmadd_ps( r2, _mm512_mask_i32gather_ps(zero, all, id, cZ, 4), r3 ) ) ) );
+
+			__m512i flip = _mm512_mask_mov_epi32( signBit, _mm512_cmplt_epi32_mask(u, zeroBits), allBits );
+
+			_mm512_storeu_si512( (void*)(k + i), _mm512_xor_si512(u, flip) );
+
+		}
+#elif defined(CENTROID_AVX2)
+		__m256 r0 = _mm256_set1_ps(mv[row]), r1 = _mm256_set1_ps(mv[row+4]),
+			r2 = _mm256_set1_ps(mv[row+8]), r3 = _mm256_set1_ps(mv[row+12]);
+		__m256i signBit = _mm256_set1_epi32(0x80000000);
+
+		for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+
+			__m256i id = _mm256_loadu_si256( (const __m256i*)(order + i) );
+
+			__m256i u = _mm256_castps_si256(
+				_mm256_fmadd_ps( r0, _mm256_i32gather_ps(cX, id, 4),
+						 _mm256_fmadd_ps( r1, _mm256_i32gather_ps(cY, id, 4),
+								  _mm256_fmadd_ps( r2, _mm256_i32gather_ps(cZ, id, 4), r3 ) ) ) );
+
+			__m256i flip = _mm256_or_si256( _mm256_srai_epi32(u, 31), signBit );
+
+			_mm256_storeu_si256( (__m256i*)(k + i), _mm256_xor_si256(u, flip) );
+
+		}
+#endif
+
+		/// Portable path (and remaining centroids)
+		for (; i < end; ++i)
+			k[i] = cpuSort::floatKey( rowDot( mv + row, cX[ order[i] ], cY[ order[i] ], cZ[ order[i] ] ) );
+
+	}
+
+}
+
+/// Split levels
+GLuint centroidStore::splitLevels(GLuint leafSize) const {
+
+	GLuint levels = 0;
+
+	while( ( (numCentroids + (1u << levels) - 1) >> levels ) > leafSize ) ++levels;
+
+	return levels;
+
+}
+
+/// Compare tets by one centroid coordinate
+struct coordLess {
+	const GLfloat *coord;
+	coordLess(const GLfloat *_c) : coord(_c) { }
+	bool operator () (GLuint a, GLuint b) const { return coord[a] < coord[b]; }
+};
+
+/// Range of a node given its level and index in the level (heap order)
+static void nodeRange(GLuint n, GLuint level, GLuint j, GLuint& begin, GLuint& end) {
+
+	begin = 0; end = n;
+
+	for (GLint l = level - 1; l >= 0; --l) {
+
+		GLuint mid = begin + (end - begin) / 2;
+
+		if( (j >> l) & 1 ) begin = mid;
+		else end = mid;
+
+	}
+
+}
+
+/// Median split
+void centroidStore::medianSplit(GLuint *perm, GLuint levels, GLubyte *axis, GLuint *leafStart) const {
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numCentroids; ++i)
+		perm[i] = i;
+
+	const GLfloat *coords[3] = { cX, cY, cZ };
+
+	/// Split one level at a time, the nodes of a level in parallel
+	for (GLuint level = 0; level < levels; ++level) {
+
+		GLint levelNodes = 1 << level;
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (GLint j = 0; j < levelNodes; ++j) {
+
+			GLuint begin, end;
+			nodeRange(numCentroids, level, j, begin, end);
+
+			/// Longest axis of the centroids bounding box
+			GLfloat lo[3] = { cX[ perm[begin] ], cY[ perm[begin] ], cZ[ perm[begin] ] };
+			GLfloat hi[3] = { lo[0], lo[1], lo[2] };
+
+			for (GLuint i = begin + 1; i < end; ++i) {
+				for (GLuint k = 0; k < 3; ++k) {
+					GLfloat v = coords[k][ perm[i] ];
+					if( v < lo[k] ) lo[k] = v;
+					if( v > hi[k] ) hi[k] = v;
+				}
+			}
+
+			GLubyte a = 0;
+			if( hi[1] - lo[1] > hi[a] - lo[a] ) a = 1;
+			if( hi[2] - lo[2] > hi[a] - lo[a] ) a = 2;
+
+			if( axis ) axis[ (1 << level) - 1 + j ] = a;
+
+			/// Median split: the lower half goes to the first child
+			std::nth_element( perm + begin, perm + begin + (end - begin) / 2, perm + end, coordLess(coords[a]) );
+
+		}
+
+	}
+
+	if( !leafStart ) return;
+
+	GLuint numLeaves = 1 << levels, end;
+
+	for (GLuint j = 0; j < numLeaves; ++j)
+		nodeRange(numCentroids, levels, j, leafStart[j], end);
+
+	leafStart[numLeaves] = numCentroids;
+
+}
@@ -0,0 +1,619 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   cpuRenderer : defines a class for multithreaded CPU (software)
+ *                 rendering of the projected tetrahedra, the same
+ *                 pipeline of hapt_dvr.geom and hapt_dvr.frag without
+ *                 a geometry-shader GPU.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "cpuRenderer.h"
+
+#include "tables.h"
+
+#include <cmath>
+#include <algorithm>
+
+/// ----------------------------------   cpuRenderer   ------------------------------------
+
+/// Constructor
+cpuRenderer::cpuRenderer() :
+	psi(NULL), psiSizeBack(0), psiSizeFront(0),
+	brightness(1.0),
+	frame(NULL), frameW(0), frameH(0),
+	tilesX(0), tilesY(0),
+	clipVerts(NULL), numClipVerts(0),
+	batchTris(NULL), batchCount(NULL),
+	tileStart(NULL), tileTris(NULL), tileTrisSize(0),
+	threadCount(NULL),
+	lastTris(0), lastFrags(0) {
+
+}
+
+/// Destructor
+cpuRenderer::~cpuRenderer() {
+
+	if( frame ) delete [] frame;
+
+	if( clipVerts ) delete [] clipVerts;
+
+	if( batchTris ) delete [] batchTris;
+
+	if( batchCount ) delete [] batchCount;
+
+	if( tileStart ) delete [] tileStart;
+
+	if( tileTris ) delete [] tileTris;
+
+	if( threadCount ) delete [] threadCount;
+
+}
+
+/// Initialize
+bool cpuRenderer::init(const GLfloat *_psi, GLuint _sizeBack, GLuint _sizeFront) {
+
+	psi = _psi;
+	psiSizeBack = _sizeBack;
+	psiSizeFront = _sizeFront;
+
+	if( !batchTris ) batchTris = new softVertex[ RENDER_BATCH * MAX_TET_TRIS * 3 ];
+	if( !batchTris ) return false;
+
+	if( !batchCount ) batchCount = new GLubyte[ RENDER_BATCH ];
+	if( !batchCount ) return false;
+
+	return true;
+
+}
+
+/// Resize
+bool cpuRenderer::resize(GLuint w, GLuint h) {
+
+	if( frame && w == frameW && h == frameH ) return true;
+
+	frameW = w;
+	frameH = h;
+
+	if( frame ) delete [] frame;
+	frame = new GLfloat[ w * h * 4 ];
+	if( !frame ) return false;
+
+	tilesX = (w + RENDER_TILE - 1) / RENDER_TILE;
+	tilesY = (h + RENDER_TILE - 1) / RENDER_TILE;
+
+	if( tileStart ) delete [] tileStart;
+	tileStart = new GLuint[ tilesX * tilesY + 1 ];
+	if( !tileStart ) return false;
+
+	if( threadCount ) delete [] threadCount;
+	threadCount = new GLuint[ omp_get_max_threads() * tilesX * tilesY ];
+	if( !threadCount ) return false;
+
+	clear(0.0, 0.0, 0.0);
+
+	return true;
+
+}
+
+/// Clear
+void cpuRenderer::clear(GLfloat r, GLfloat g, GLfloat b) {
+
+#pragma omp parallel for
+	for (GLint p = 0; p < (GLint)(frameW * frameH); ++p) {
+		frame[p*4 + 0] = r;
+		frame[p*4 + 1] = g;
+		frame[p*4 + 2] = b;
+		frame[p*4 + 3] = 0.0;
+	}
+
+}
+
+/// Screen vertex
+void cpuRenderer::screenVertex(const GLfloat *c, GLfloat sf, GLfloat sb, GLfloat l, softVertex& sv) const {
+
+	sv.iw = 1.0 / c[3];
+
+	/// Window coordinates snapped to the sub-pixel grid
+	sv.x = floor( (c[0] * sv.iw + 1.0) * 0.5 * frameW * RENDER_SUBPIXEL + 0.5 ) / RENDER_SUBPIXEL;
+	sv.y = floor( (c[1] * sv.iw + 1.0) * 0.5 * frameH * RENDER_SUBPIXEL + 0.5 ) / RENDER_SUBPIXEL;
+
+	sv.sf = sf * sv.iw;
+	sv.sb = sb * sv.iw;
+	sv.l = l * sv.iw;
+
+}
+
+/// Project tetrahedron
+GLuint cpuRenderer::projectTet(const GLfloat v[4][4], const GLfloat s[4], softVertex *tris) const {
+
+	/// Classification: cross products z of the clip coordinates
+	GLfloat e10[2], e20[2], e30[2], e12[2], e13[2], c[4];
+
+	for (GLuint k = 0; k < 2; ++k) {
+		e10[k] = v[1][k] - v[0][k];
+		e20[k] = v[2][k] - v[0][k];
+		e30[k] = v[3][k] - v[0][k];
+		e12[k] = v[1][k] - v[2][k];
+		e13[k] = v[1][k] - v[3][k];
+	}
+
+	c[0] = e10[0] * e20[1] - e10[1] * e20[0];
+	c[1] = e10[0] * e30[1] - e10[1] * e30[0];
+	c[2] = e20[0] * e30[1] - e20[1] * e30[0];
+	c[3] = e12[0] * e13[1] - e12[1] * e13[0];
+
+	GLint countTFan = 5, idTTT = 0;
+
+	for (GLuint i = 0; i < 4; ++i) {
+
+		GLint test = ( c[i] > 0.0 ) ? 2 : ( ( c[i] < 0.0 ) ? 0 : 1 );
+
+		if( test == 1 ) --countTFan;
+
+		idTTT = idTTT * 3 + test;
+
+	}
+
+	if( countTFan < 3 ) return 0;
+
+	/// Vertices in the basis graph order
+	const GLfloat *vo[4];
+	GLfloat so[4];
+
+	for (GLuint i = 0; i < 4; ++i) {
+		vo[i] = v[ order_table[idTTT][i] ];
+		so[i] = s[ order_table[idTTT][i] ];
+	}
+
+	/// Line intersection parameters
+	GLfloat paramU1 = 1.0, paramU2 = 1.0;
+
+	if( countTFan > 3 ) {
+
+		/// Line intersection denominator between v0->v2 and v1->v3
+		GLfloat denominator = ((vo[3][1] - vo[1][1]) * (vo[2][0] - vo[0][0])) -
+			((vo[3][0] - vo[1][0]) * (vo[2][1] - vo[0][1]));
+
+		/// Line defined by vector v1->v3
+		paramU2 = ( ((vo[2][0] - vo[0][0]) * (vo[0][1] - vo[1][1])) -
+			    ((vo[2][1] - vo[0][1]) * (vo[0][0] - vo[1][0])) ) / denominator;
+
+		/// Line defined by vector v0->v2
+		if( countTFan == 5 )
+			paramU1 = ( ((vo[3][0] - vo[1][0]) * (vo[0][1] - vo[1][1])) -
+				    ((vo[3][1] - vo[1][1]) * (vo[0][0] - vo[1][0])) ) / denominator;
+
+	}
+
+	/// Intersection (thick) vertex and thickness
+	GLfloat thickVert[4] = { 0.0, 0.0, 0.0, 0.0 }, thickness;
+
+	if( countTFan == 3 ) {
+
+		thickness = vo[0][2] - vo[1][2];
+
+	} else {
+
+		GLfloat zBackIntersection = vo[1][2] + paramU2 * (vo[3][2] - vo[1][2]);
+
+		if( countTFan == 4 ) thickness = vo[2][2] - zBackIntersection;
+		else {
+
+			for (GLuint k = 0; k < 4; ++k)
+				thickVert[k] = vo[0][k] + paramU1 * (vo[2][k] - vo[0][k]);
+
+			thickness = thickVert[2] - zBackIntersection;
+
+		}
+
+	}
+
+	if( countTFan == 5 ) {
+
+		if( paramU1 > 1.0 ) {
+
+			thickness /= paramU1;
+			paramU1 = 1.0 / paramU1;
+
+		} else countTFan = 6; ///< Thick vertex is the intersection vertex
+
+	}
+
+	/// Scalars front and back of the thick vertex
+	GLfloat scalarFront, scalarBack;
+
+	if( countTFan == 6 ) {
+
+		scalarFront = so[0] + paramU1 * (so[2] - so[0]);
+		scalarBack = so[1] + paramU2 * (so[3] - so[1]);
+
+	} else if( countTFan == 5 ) {
+
+		scalarFront = so[2];
+		GLfloat tmp = so[1] + paramU2 * (so[3] - so[1]);
+		scalarBack = so[0] + (tmp - so[0]) * paramU1;
+
+	} else if( countTFan == 4 ) {
+
+		scalarFront = so[2];
+		scalarBack = so[1] + paramU2 * (so[3] - so[1]);
+
+	} else {
+
+		scalarFront = so[0];
+		scalarBack = so[1];
+
+	}
+
+	thickness = fabs(thickness);
+
+	/// Triangle fan/strip order (first four valid entries)
+	GLint tfanId[4], k = 0;
+
+	for (GLuint j = 0; j < 5 && k < 4; ++j)
+		if( triangle_fan_order_table[idTTT][j] != -1 )
+			tfanId[k++] = triangle_fan_order_table[idTTT][j];
+
+	/// Triangle strip, the thick vertex is in every triangle
+	softVertex strip[5];
+	GLuint numStrip;
+
+	if( countTFan == 6 ) {
+
+		screenVertex( v[ tfanId[0] ], s[ tfanId[0] ], s[ tfanId[0] ], 0.0, strip[0] );
+		screenVertex( v[ tfanId[1] ], s[ tfanId[1] ], s[ tfanId[1] ], 0.0, strip[1] );
+		screenVertex( thickVert, scalarFront, scalarBack, thickness, strip[2] );
+		screenVertex( v[ tfanId[2] ], s[ tfanId[2] ], s[ tfanId[2] ], 0.0, strip[3] );
+		screenVertex( v[ tfanId[3] ], s[ tfanId[3] ], s[ tfanId[3] ], 0.0, strip[4] );
+
+		numStrip = 5;
+
+	} else {
+
+		screenVertex( v[ tfanId[1] ], s[ tfanId[1] ], s[ tfanId[1] ], 0.0, strip[0] );
+		screenVertex( v[ tfanId[2] ], s[ tfanId[2] ], s[ tfanId[2] ], 0.0, strip[1] );
+		screenVertex( v[ tfanId[0] ], scalarFront, scalarBack, thickness, strip[2] );
+
+		if( countTFan > 3 ) screenVertex( v[ tfanId[3] ], s[ tfanId[3] ], s[ tfanId[3] ], 0.0, strip[3] );
+
+		if( countTFan > 4 ) strip[4] = strip[0];
+
+		numStrip = countTFan;
+
+	}
+
+	GLuint numTris = 0;
+
+	for (GLuint i = 0; i + 2 < numStrip; ++i, ++numTris) {
+		tris[numTris*3 + 0] = strip[i];
+		tris[numTris*3 + 1] = strip[i + 1];
+		tris[numTris*3 + 2] = strip[i + 2];
+	}
+
+	if( countTFan == 6 ) { ///< Closing triangle (thick, t3, t0)
+		tris[numTris*3 + 0] = strip[2];
+		tris[numTris*3 + 1] = strip[4];
+		tris[numTris*3 + 2] = strip[0];
+		++numTris;
+	}
+
+	return numTris;
+
+}
+
+/// Tile bounds
+bool cpuRenderer::tileBounds(const softVertex *t, GLint& tx0, GLint& ty0, GLint& tx1, GLint& ty1) const {
+
+	GLfloat minX = t[0].x, maxX = t[0].x, minY = t[0].y, maxY = t[0].y;
+
+	for (GLuint i = 0; i < 3; ++i) {
+
+		/// Behind the eye, too far or degenerated (no clipping)
+		if( !( t[i].iw > 0.0 ) || !( fabs(t[i].x) < RENDER_MAX_COORD ) || !( fabs(t[i].y) < RENDER_MAX_COORD ) )
+			return false;
+
+		if( t[i].x < minX ) minX = t[i].x;
+		if( t[i].x > maxX ) maxX = t[i].x;
+		if( t[i].y < minY ) minY = t[i].y;
+		if( t[i].y > maxY ) maxY = t[i].y;
+
+	}
+
+	/// Pixels with the center inside the bounding box
+	GLint px0 = (GLint)ceil(minX - 0.5), px1 = (GLint)floor(maxX - 0.5);
+	GLint py0 = (GLint)ceil(minY - 0.5), py1 = (GLint)floor(maxY - 0.5);
+
+	if( px1 < 0 || py1 < 0 || px0 >= (GLint)frameW || py0 >= (GLint)frameH || px0 > px1 || py0 > py1 )
+		return false;
+
+	tx0 = ( px0 < 0 ) ? 0 : px0 / RENDER_TILE;
+	ty0 = ( py0 < 0 ) ? 0 : py0 / RENDER_TILE;
+	tx1 = ( px1 >= (GLint)frameW ) ? tilesX - 1 : px1 / RENDER_TILE;
+	ty1 = ( py1 >= (GLint)frameH ) ? tilesY - 1 : py1 / RENDER_TILE;
+
+	return true;
+
+}
+
+/// Rasterize
+GLuint cpuRenderer::rasterize(const softVertex *t, const GLfloat *tf, GLuint numColors, GLfloat lScale,
+			      GLint x0, GLint y0, GLint x1, GLint y1) {
+
+	const softVertex *a = &t[0], *b = &t[1], *c = &t[2];
+
+	/// Exact in double precision (snapped coordinates)
+	GLdouble area = (b->x - a->x) * (GLdouble)(c->y - a->y) - (b->y - a->y) * (GLdouble)(c->x - a->x);
+
+	if( area == 0.0 ) return 0;
+
+	if( area < 0.0 ) { ///< Counter-clockwise
+		const softVertex *tmp = b; b = c; c = tmp;
+		area = -area;
+	}
+
+	/// Pixel bounds inside the tile
+	GLfloat minX = std::min( a->x, std::min( b->x, c->x ) ), maxX = std::max( a->x, std::max( b->x, c->x ) );
+	GLfloat minY = std::min( a->y, std::min( b->y, c->y ) ), maxY = std::max( a->y, std::max( b->y, c->y ) );
+
+	GLint px0 = std::max( x0, (GLint)ceil(minX - 0.5) ), px1 = std::min( x1 - 1, (GLint)floor(maxX - 0.5) );
+	GLint py0 = std::max( y0, (GLint)ceil(minY - 0.5) ), py1 = std::min( y1 - 1, (GLint)floor(maxY - 0.5) );
+
+	/// Edge functions E(x, y) = A x + B y + C of b->c, c->a and a->b
+	/// (weights of a, b and c), positive inside
+	const softVertex *p[3] = { b, c, a }, *q[3] = { c, a, b };
+	GLdouble eA[3], eB[3], eC[3];
+	bool topLeft[3];
+
+	for (GLuint e = 0; e < 3; ++e) {
+
+		GLdouble dx = q[e]->x - p[e]->x, dy = q[e]->y - p[e]->y;
+
+		eA[e] = -dy;
+		eB[e] = dx;
+		eC[e] = dy * p[e]->x - dx * p[e]->y;
+
+		/// Fill rule: pixels on a shared edge belong to one triangle
+		topLeft[e] = ( dy > 0.0 ) || ( dy == 0.0 && dx < 0.0 );
+
+	}
+
+	GLdouble invArea = 1.0 / area;
+
+	GLuint frags = 0;
+
+	for (GLint py = py0; py <= py1; ++py) {
+
+		GLdouble sy = py + 0.5;
+
+		GLfloat *dst = frame + (py * frameW + px0) * 4;
+
+		for (GLint px = px0; px <= px1; ++px, dst += 4) {
+
+			GLdouble sx = px + 0.5;
+			GLfloat w[3];
+			bool inside = true;
+
+			for (GLuint e = 0; e < 3 && inside; ++e) {
+				GLdouble ev = eA[e] * sx + eB[e] * sy + eC[e];
+				inside = ( ev > 0.0 ) || ( ev == 0.0 && topLeft[e] );
+				w[e] = ev * invArea;
+			}
+
+			if( !inside ) continue;
+
+			++frags;
+
+			/// Perspective correct attributes
+			GLfloat iw = w[0] * a->iw + w[1] * b->iw + w[2] * c->iw;
+
+			GLfloat l = ( w[0] * a->l + w[1] * b->l + w[2] * c->l ) / iw;
+
+			if( l <= 0.0 ) continue; ///< No fragment color
+
+			GLfloat sf = ( w[0] * a->sf + w[1] * b->sf + w[2] * c->sf ) / iw;
+			GLfloat sb = ( w[0] * a->sb + w[1] * b->sb + w[2] * c->sb ) / iw;
+
+			l *= lScale; ///< Brightness and normalized thickness
+
+			/// Transfer function (nearest, clamp to edge)
+			GLint i = (GLint)(sf * numColors);
+			const GLfloat *colorFront = tf + 4 * ( ( i < 0 ) ? 0 : ( ( i >= (GLint)numColors ) ? numColors - 1 : i ) );
+			i = (GLint)(sb * numColors);
+			const GLfloat *colorBack = tf + 4 * ( ( i < 0 ) ? 0 : ( ( i >= (GLint)numColors ) ? numColors - 1 : i ) );
+
+			GLfloat tauFront = colorFront[3] * l, tauBack = colorBack[3] * l;
+
+			GLfloat zeta = exp( -0.5 * (tauFront + tauBack) );
+
+			if( zeta == 1.0 ) continue; ///< No fragment color
+
+			/// Psi gamma table (nearest)
+			GLint gx = (GLint)( tauFront / (1.0 + tauFront) * psiSizeBack + 0.5 );
+			GLint gy = (GLint)( tauBack / (1.0 + tauBack) * psiSizeFront + 0.5 );
+
+			if( gx >= (GLint)psiSizeBack ) gx = psiSizeBack - 1;
+			if( gy >= (GLint)psiSizeFront ) gy = psiSizeFront - 1;
+
+			GLfloat ps = psi[ gy * psiSizeBack + gx ];
+
+			/// Blend (GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+			GLfloat alpha = 1.0 - zeta;
+
+			for (GLuint k = 0; k < 3; ++k)
+				dst[k] = colorFront[k] * (1.0 - ps) + colorBack[k] * (ps - zeta) + (1.0 - alpha) * dst[k];
+
+			dst[3] = alpha + (1.0 - alpha) * dst[3];
+
+		}
+
+	}
+
+	return frags;
+
+}
+
+/// Render
+void cpuRenderer::render(const offVol< GLfloat, GLuint >& vol, const GLuint *ids, GLuint n, const GLfloat *mvp) {
+
+	lastTris = 0;
+	lastFrags = 0;
+
+	if( !frame || !psi || !batchTris ) return;
+
+	GLuint nV = vol.numVerts, nT = n, numTiles = tilesX * tilesY;
+
+	/// Clip coordinates of the vertices (hapt.vert)
+	if( numClipVerts < nV ) {
+		if( clipVerts ) delete [] clipVerts;
+		clipVerts = new GLfloat[ nV * 4 ];
+		if( !clipVerts ) { numClipVerts = 0; return; }
+		numClipVerts = nV;
+	}
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nV; ++i)
+		for (GLuint r = 0; r < 4; ++r)
+			clipVerts[i*4 + r] = mvp[r] * vol.vertList[i][0] + mvp[4 + r] * vol.vertList[i][1]
+				+ mvp[8 + r] * vol.vertList[i][2] + mvp[12 + r];
+
+	/// Transfer function and thickness scale (hapt_dvr.frag uniforms)
+	GLuint numColors = vol.numColors;
+
+	GLfloat *tf = new GLfloat[ numColors * 4 ];
+
+	for (GLuint i = 0; i < numColors; ++i)
+		for (GLuint j = 0; j < 4; ++j)
+			tf[i*4 + j] = vol.tf[i][j];
+
+	GLfloat lScale = brightness / vol.maxEdgeLength;
+
+	unsigned long long frags = 0;
+
+	for (GLuint b = 0; b < nT; b += RENDER_BATCH) {
+
+		GLuint nB = std::min( (GLuint)RENDER_BATCH, nT - b );
+
+		GLuint tris = 0;
+
+		/// Project and split the tets in triangles
+#pragma omp parallel for reduction(+:tris)
+		for (GLint i = 0; i < (GLint)nB; ++i) {
+
+			GLuint t = ids[b + i];
+
+			GLfloat v[4][4], s[4];
+
+			for (GLuint j = 0; j < 4; ++j) {
+				memcpy( v[j], clipVerts + vol.tetList[t][j] * 4, 4 * sizeof(GLfloat) );
+				s[j] = vol.vertList[ vol.tetList[t][j] ][3];
+			}
+
+			batchCount[i] = projectTet( v, s, batchTris + i * MAX_TET_TRIS * 3 );
+
+			tris += batchCount[i];
+
+		}
+
+		lastTris += tris;
+
+		/// Bin the triangles in tiles, keeping the order: each thread
+		/// counts and fills its contiguous range of tets
+#pragma omp parallel
+		{
+
+			GLuint nt = omp_get_num_threads(), th = omp_get_thread_num();
+			GLuint begin = (GLuint)( (unsigned long long)nB * th / nt );
+			GLuint end = (GLuint)( (unsigned long long)nB * (th + 1) / nt );
+
+			GLuint *count = threadCount + th * numTiles;
+
+			memset( count, 0, numTiles * sizeof(GLuint) );
+
+			GLint tx0, ty0, tx1, ty1;
+
+			for (GLuint i = begin; i < end; ++i)
+				for (GLuint k = 0; k < batchCount[i]; ++k)
+					if( tileBounds( batchTris + (i * MAX_TET_TRIS + k) * 3, tx0, ty0, tx1, ty1 ) )
+						for (GLint ty = ty0; ty <= ty1; ++ty)
+							for (GLint tx = tx0; tx <= tx1; ++tx)
+								++count[ ty * tilesX + tx ];
+
+#pragma omp barrier
+
+#pragma omp single
+			{
+
+				/// Tile lists: thread ranges in order inside each tile
+				GLuint sum = 0;
+
+				for (GLuint tile = 0; tile < numTiles; ++tile) {
+					tileStart[tile] = sum;
+					for (GLuint j = 0; j < nt; ++j) {
+						GLuint c = threadCount[ j * numTiles + tile ];
+						threadCount[ j * numTiles + tile ] = sum;
+						sum += c;
+					}
+				}
+
+				tileStart[numTiles] = sum;
+
+				if( sum > tileTrisSize ) {
+					if( tileTris ) delete [] tileTris;
+					tileTrisSize = sum + sum / 2;
+					tileTris = new GLuint[ tileTrisSize ];
+				}
+
+			}
+
+			for (GLuint i = begin; i < end; ++i)
+				for (GLuint k = 0; k < batchCount[i]; ++k)
+					if( tileBounds( batchTris + (i * MAX_TET_TRIS + k) * 3, tx0, ty0, tx1, ty1 ) )
+						for (GLint ty = ty0; ty <= ty1; ++ty)
+							for (GLint tx = tx0; tx <= tx1; ++tx)
+								tileTris[ count[ ty * tilesX + tx ]++ ] = i * MAX_TET_TRIS + k;
+
+		}
+
+		/// Rasterize the tiles in parallel, each one back-to-front
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:frags)
+		for (GLint tile = 0; tile < (GLint)numTiles; ++tile) {
+
+			GLint x0 = (tile % tilesX) * RENDER_TILE, y0 = (tile / tilesX) * RENDER_TILE;
+			GLint x1 = std::min( x0 + RENDER_TILE, (GLint)frameW ), y1 = std::min( y0 + RENDER_TILE, (GLint)frameH );
+
+			for (GLuint j = tileStart[tile]; j < tileStart[tile + 1]; ++j)
+				frags += rasterize( batchTris + tileTris[j] * 3, tf, numColors, lScale, x0, y0, x1, y1 );
+
+		}
+
+	}
+
+	lastFrags = frags;
+
+	delete [] tf;
+
+}
+
+/// Size of renderer
+size_t cpuRenderer::sizeOf(void) {
+
+	return ( ( (frame) ? frameW * frameH * 4 * sizeof(GLfloat) : 0 ) + ///< Frame buffer
+		 ( (clipVerts) ? numClipVerts * 4 * sizeof(GLfloat) : 0 ) + ///< Clip coordinates
+		 ( (batchTris) ? RENDER_BATCH * MAX_TET_TRIS * 3 * sizeof(softVertex) : 0 ) + ///< Batch triangles
+		 ( (batchCount) ? RENDER_BATCH * sizeof(GLubyte) : 0 ) + ///< Batch triangles per tet
+		 ( (tileStart) ? (tilesX * tilesY + 1) * sizeof(GLuint) : 0 ) + ///< Tile list starts
+		 ( tileTrisSize * sizeof(GLuint) ) + ///< Tile lists
+		 ( (threadCount) ? omp_get_max_threads() * tilesX * tilesY * sizeof(GLuint) : 0 ) + ///< Binning counts
+		 ( 11 * sizeof(GLuint) ) + ///< All GLuints
+		 ( 8 * sizeof(void*) ) ///< All pointers
+		);
+
+}
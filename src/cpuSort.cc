@@ -0,0 +1,634 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   cpuSort : defines a class for multithreaded CPU sorting of the
+ *             tetrahedra centroids, used when no CUDA device is available.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include <algorithm>
+
+#include "cpuSort.h"
+
+/// Minimum number of elements per sorting thread
+#define MIN_PER_THREAD 16384
+
+/// ----------------------------------   cpuSort   ------------------------------------
+
+/// Constructor
+cpuSort::cpuSort() :
+	maxSize(0), maxThreads(1),
+	histograms(NULL), centroidTmp(NULL),
+	samples(NULL), bucketCounts(NULL) {
+
+	for (GLuint i = 0; i < 2; ++i) {
+		keysTmp[i] = NULL;
+		idsTmp[i] = NULL;
+	}
+
+}
+
+/// Destructor
+cpuSort::~cpuSort() {
+
+	for (GLuint i = 0; i < 2; ++i) {
+		if( keysTmp[i] ) delete [] keysTmp[i];
+		if( idsTmp[i] ) delete [] idsTmp[i];
+	}
+
+	if( histograms ) delete [] histograms;
+
+	if( centroidTmp ) delete [] centroidTmp;
+
+	if( samples ) delete [] samples;
+
+	if( bucketCounts ) delete [] bucketCounts;
+
+}
+
+/// Initialize scratch arrays
+bool cpuSort::init(GLuint _n) {
+
+	maxSize = _n;
+
+	maxThreads = omp_get_max_threads();
+
+	for (GLuint i = 0; i < 2; ++i) {
+
+		if( keysTmp[i] ) delete [] keysTmp[i];
+		keysTmp[i] = new GLuint[ maxSize ];
+		if( !keysTmp[i] ) return false;
+
+		if( idsTmp[i] ) delete [] idsTmp[i];
+		idsTmp[i] = new GLuint[ maxSize ];
+		if( !idsTmp[i] ) return false;
+
+	}
+
+	if( histograms ) delete [] histograms;
+	histograms = new GLuint[ maxThreads * HISTOGRAM_SIZE ];
+	if( !histograms ) return false;
+
+	if( centroidTmp ) delete [] centroidTmp;
+	centroidTmp = new tetCentroid[ maxSize ];
+	if( !centroidTmp ) return false;
+
+	if( samples ) delete [] samples;
+	samples = new GLfloat[ maxThreads * OVERSAMPLING ];
+	if( !samples ) return false;
+
+	if( bucketCounts ) delete [] bucketCounts;
+	bucketCounts = new GLuint[ (maxThreads + 1) * maxThreads ];
+	if( !bucketCounts ) return false;
+
+	return true;
+
+}
+
+/// Size of CPU sort scratch memory
+size_t cpuSort::sizeOf(void) {
+
+	return ( ( (size_t)4 * maxSize * sizeof(GLuint) ) + ///< Ping-pong keys and ids
+		 ( maxThreads * HISTOGRAM_SIZE * sizeof(GLuint) ) + ///< Histograms
+		 ( maxSize * sizeof(tetCentroid) ) + ///< Sample sort scatter array
+		 ( maxThreads * OVERSAMPLING * sizeof(GLfloat) ) + ///< Samples
+		 ( (maxThreads + 1) * maxThreads * sizeof(GLuint) ) + ///< Bucket counts and starts
+		 ( 2 * sizeof(GLuint) ) + ///< maxSize and maxThreads
+		 ( 8 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Radix Sort
+void cpuSort::radixSort(GLuint *ids, const GLuint *keys, GLuint n) {
+
+	if( n == 0 || n > maxSize ) return;
+
+	GLuint numThreads = n / MIN_PER_THREAD + 1;
+	if( numThreads > maxThreads ) numThreads = maxThreads;
+
+#pragma omp parallel num_threads(numThreads)
+	{
+
+		GLuint t = omp_get_thread_num(), nt = omp_get_num_threads();
+
+		/// Each thread owns one contiguous chunk of the input
+		GLuint begin = (GLuint)( ( (unsigned long long)n * t ) / nt );
+		GLuint end = (GLuint)( ( (unsigned long long)n * (t+1) ) / nt );
+
+		GLuint *hist = histograms + t * RADIX_BUCKETS;
+
+		for (GLuint pass = 0; pass < RADIX_PASSES; ++pass) {
+
+			GLuint shift = pass * RADIX_BITS;
+
+			bool first = (pass == 0), last = (pass == RADIX_PASSES - 1);
+
+			/// First pass reads the input keys with implicit ids,
+			/// last pass writes only the ids into the output
+			const GLuint *srcKeys = first ? keys : keysTmp[ (pass-1) & 1 ];
+			const GLuint *srcIds = first ? NULL : idsTmp[ (pass-1) & 1 ];
+			GLuint *dstKeys = keysTmp[ pass & 1 ];
+			GLuint *dstIds = last ? ids : idsTmp[ pass & 1 ];
+
+			memset( hist, 0, RADIX_BUCKETS * sizeof(GLuint) );
+
+			for (GLuint i = begin; i < end; ++i)
+				++hist[ (srcKeys[i] >> shift) & (RADIX_BUCKETS - 1) ];
+
+#pragma omp barrier
+
+#pragma omp single
+			{
+				/// Exclusive prefix sum digit-major, thread-minor (keeps it stable)
+				GLuint sum = 0, count;
+				for (GLuint d = 0; d < RADIX_BUCKETS; ++d) {
+					for (GLuint tt = 0; tt < nt; ++tt) {
+						count = histograms[ tt * RADIX_BUCKETS + d ];
+						histograms[ tt * RADIX_BUCKETS + d ] = sum;
+						sum += count;
+					}
+				}
+			}
+
+			GLuint key, pos;
+
+			for (GLuint i = begin; i < end; ++i) {
+
+				key = srcKeys[i];
+				pos = hist[ (key >> shift) & (RADIX_BUCKETS - 1) ]++;
+
+				if( !last ) dstKeys[pos] = key;
+				dstIds[pos] = first ? i : srcIds[i];
+
+			}
+
+#pragma omp barrier
+
+		}
+
+	}
+
+}
+
+/// Merge Runs
+void cpuSort::mergeRuns(GLuint *ids, GLuint *keys, GLuint a, GLuint m, GLuint b) {
+
+	if( a == m || m == b ) return;
+
+	if( keys[m-1] <= keys[m] ) return; ///< Already in order
+
+	/// Only [lo, m) from the left run and [m, hi) from the right run are out of place
+	GLuint lo = std::upper_bound( keys + a, keys + m, keys[m] ) - keys;
+	GLuint hi = std::lower_bound( keys + m, keys + b, keys[m-1] ) - keys;
+
+	GLuint *mKeys = keysTmp[0], *mIds = idsTmp[0];
+	GLuint i = lo, j = m, k = lo;
+
+	while( i < m && j < hi ) {
+		if( keys[j] < keys[i] ) { mKeys[k] = keys[j]; mIds[k++] = ids[j++]; }
+		else { mKeys[k] = keys[i]; mIds[k++] = ids[i++]; }
+	}
+	while( i < m ) { mKeys[k] = keys[i]; mIds[k++] = ids[i++]; }
+	while( j < hi ) { mKeys[k] = keys[j]; mIds[k++] = ids[j++]; }
+
+	memcpy( keys + lo, mKeys + lo, (hi - lo) * sizeof(GLuint) );
+	memcpy( ids + lo, mIds + lo, (hi - lo) * sizeof(GLuint) );
+
+}
+
+/// Adaptive Sort
+bool cpuSort::adaptiveSort(GLuint *ids, GLuint *keys, GLuint n, GLfloat maxDisorder) {
+
+	if( n == 0 ) return true;
+	if( n > maxSize ) return false;
+
+	GLuint numBlocks = n / MIN_PER_THREAD + 1;
+	if( numBlocks > maxThreads ) numBlocks = maxThreads;
+
+	bool overflow = false;
+
+	/// Block insertion sort, aborting when a block moves too much
+#pragma omp parallel for num_threads(numBlocks) schedule(static, 1) reduction(||:overflow)
+	for (GLint t = 0; t < (GLint)numBlocks; ++t) {
+
+		GLuint begin = (GLuint)( ( (unsigned long long)n * t ) / numBlocks );
+		GLuint end = (GLuint)( ( (unsigned long long)n * (t+1) ) / numBlocks );
+
+		unsigned long long moves = 0;
+		unsigned long long maxMoves = (unsigned long long)( maxDisorder * (end - begin) );
+
+		GLuint key, id, j;
+
+		for (GLuint i = begin + 1; i < end; ++i) {
+
+			key = keys[i];
+			if( keys[i-1] <= key ) continue;
+
+			id = ids[i];
+			j = i;
+
+			do {
+				keys[j] = keys[j-1];
+				ids[j] = ids[j-1];
+				--j;
+			} while( j > begin && keys[j-1] > key );
+
+			keys[j] = key;
+			ids[j] = id;
+
+			moves += i - j;
+
+			if( moves > maxMoves ) {
+				overflow = true;
+				break;
+			}
+
+		}
+
+	}
+
+	if( overflow ) return false;
+
+	/// Pairwise merge of the sorted blocks (log numBlocks rounds)
+	for (GLuint width = 1; width < numBlocks; width *= 2) {
+
+#pragma omp parallel for num_threads(numBlocks)
+		for (GLint t = 0; t < (GLint)numBlocks; t += 2*width) {
+
+			GLuint mid = t + width, last = t + 2*width;
+			if( mid >= numBlocks ) continue;
+			if( last > numBlocks ) last = numBlocks;
+
+			mergeRuns( ids, keys,
+				   (GLuint)( ( (unsigned long long)n * t ) / numBlocks ),
+				   (GLuint)( ( (unsigned long long)n * mid ) / numBlocks ),
+				   (GLuint)( ( (unsigned long long)n * last ) / numBlocks ) );
+
+		}
+
+	}
+
+	return true;
+
+}
+
+/// Sample Sort
+void cpuSort::sampleSort(tetCentroid *c, GLuint n) {
+
+	if( n > maxSize ) return;
+
+	GLuint numBuckets = n / MIN_PER_THREAD + 1;
+	if( numBuckets > maxThreads ) numBuckets = maxThreads;
+
+	if( numBuckets == 1 ) { ///< Too small to split
+		std::sort( c, c + n );
+		return;
+	}
+
+	/// Regular oversampling, sorted to pick numBuckets-1 splitters
+	GLuint numSamples = numBuckets * OVERSAMPLING;
+
+	for (GLuint i = 0; i < numSamples; ++i)
+		samples[i] = c[ (GLuint)( ( (unsigned long long)n * i ) / numSamples ) ].cZ;
+
+	std::sort( samples, samples + numSamples );
+
+	for (GLuint b = 1; b < numBuckets; ++b)
+		samples[b-1] = samples[ b * OVERSAMPLING ];
+
+	const GLfloat *splitters = samples, *splittersEnd = samples + numBuckets - 1;
+
+	GLuint *bucketStarts = bucketCounts + maxThreads * maxThreads;
+
+#pragma omp parallel num_threads(numBuckets)
+	{
+
+		GLuint t = omp_get_thread_num(), nt = omp_get_num_threads();
+
+		GLuint begin = (GLuint)( ( (unsigned long long)n * t ) / nt );
+		GLuint end = (GLuint)( ( (unsigned long long)n * (t+1) ) / nt );
+
+		GLuint *counts = bucketCounts + t * numBuckets;
+
+		/// Count the chunk elements of each bucket
+		for (GLuint b = 0; b < numBuckets; ++b) counts[b] = 0;
+
+		for (GLuint i = begin; i < end; ++i)
+			++counts[ std::upper_bound( splitters, splittersEnd, c[i].cZ ) - splitters ];
+
+#pragma omp barrier
+
+#pragma omp single
+		{
+			/// Exclusive prefix sum bucket-major, thread-minor
+			GLuint sum = 0, count;
+			for (GLuint b = 0; b < numBuckets; ++b) {
+				bucketStarts[b] = sum;
+				for (GLuint tt = 0; tt < nt; ++tt) {
+					count = bucketCounts[ tt * numBuckets + b ];
+					bucketCounts[ tt * numBuckets + b ] = sum;
+					sum += count;
+				}
+			}
+		}
+
+		/// Scatter the chunk into the buckets
+		for (GLuint i = begin; i < end; ++i)
+			centroidTmp[ counts[ std::upper_bound( splitters, splittersEnd, c[i].cZ ) - splitters ]++ ] = c[i];
+
+#pragma omp barrier
+
+		/// Each thread sorts its bucket(s) and copies back
+		for (GLuint b = t; b < numBuckets; b += nt) {
+
+			GLuint bucketBegin = bucketStarts[b];
+			GLuint bucketEnd = ( b + 1 < numBuckets ) ? bucketStarts[b+1] : n;
+
+			std::sort( centroidTmp + bucketBegin, centroidTmp + bucketEnd );
+
+			memcpy( c + bucketBegin, centroidTmp + bucketBegin, (bucketEnd - bucketBegin) * sizeof(tetCentroid) );
+
+		}
+
+	}
+
+}
+
+/// Bucket Sort
+void cpuSort::bucketSort(GLuint *ids, const GLuint *keys, GLuint n, GLuint bits,
+			 GLfloat *width, GLuint *inversions) {
+
+	if( n == 0 || n > maxSize ) return;
+
+	if( bits > BUCKET_BITS_MAX ) bits = BUCKET_BITS_MAX;
+
+	const GLuint numBuckets = 1 << bits;
+
+	GLuint numThreads = n / MIN_PER_THREAD + 1;
+	if( numThreads > maxThreads ) numThreads = maxThreads;
+
+	GLuint minKey = 0xFFFFFFFF, maxKey = 0, numInversions = 0;
+	GLfloat minZ = 0.0, scale = 0.0;
+
+	/// Output keys are kept only to measure the inversions
+	GLuint *outKeys = inversions ? keysTmp[0] : NULL;
+
+	/// Bucket of each element, computed once so the count and the
+	/// scatter agree (the float rounding may differ between two loops)
+	GLuint *buckets = keysTmp[1];
+
+#pragma omp parallel num_threads(numThreads)
+	{
+
+		GLuint t = omp_get_thread_num(), nt = omp_get_num_threads();
+
+		GLuint begin = (GLuint)( ( (unsigned long long)n * t ) / nt );
+		GLuint end = (GLuint)( ( (unsigned long long)n * (t+1) ) / nt );
+
+		GLuint *hist = histograms + t * HISTOGRAM_SIZE;
+
+		/// Depth range (monotone keys compare as the depths)
+		GLuint localMin = 0xFFFFFFFF, localMax = 0;
+
+		for (GLuint i = begin; i < end; ++i) {
+			if( keys[i] < localMin ) localMin = keys[i];
+			if( keys[i] > localMax ) localMax = keys[i];
+		}
+
+#pragma omp critical
+		{
+			if( localMin < minKey ) minKey = localMin;
+			if( localMax > maxKey ) maxKey = localMax;
+		}
+
+#pragma omp barrier
+
+#pragma omp single
+		{
+			minZ = keyFloat( minKey );
+			GLfloat range = keyFloat( maxKey ) - minZ;
+			scale = ( range > 0.0 ) ? numBuckets / range : 0.0;
+		}
+
+		/// Count the chunk elements of each bucket
+		memset( hist, 0, numBuckets * sizeof(GLuint) );
+
+		GLuint b;
+
+		for (GLuint i = begin; i < end; ++i) {
+			b = (GLuint)( ( keyFloat( keys[i] ) - minZ ) * scale );
+			buckets[i] = (b < numBuckets) ? b : numBuckets - 1;
+			++hist[ buckets[i] ];
+		}
+
+#pragma omp barrier
+
+#pragma omp single
+		{
+			/// Exclusive prefix sum bucket-major, thread-minor (keeps it stable)
+			GLuint sum = 0, count;
+			for (GLuint d = 0; d < numBuckets; ++d) {
+				for (GLuint tt = 0; tt < nt; ++tt) {
+					count = histograms[ tt * HISTOGRAM_SIZE + d ];
+					histograms[ tt * HISTOGRAM_SIZE + d ] = sum;
+					sum += count;
+				}
+			}
+		}
+
+		/// Scatter the ids (and keys for measuring) in bucket order
+		GLuint pos;
+
+		for (GLuint i = begin; i < end; ++i) {
+			pos = hist[ buckets[i] ]++;
+			ids[pos] = i;
+			if( outKeys ) outKeys[pos] = keys[i];
+		}
+
+		if( outKeys ) {
+
+#pragma omp barrier
+
+			/// Neighbours out of the exact (stl) order
+			GLuint localInversions = 0;
+
+			for (GLuint i = (begin > 0) ? begin : 1; i < end; ++i)
+				if( outKeys[i-1] > outKeys[i] ) ++localInversions;
+
+#pragma omp critical
+			numInversions += localInversions;
+
+		}
+
+	}
+
+	if( width ) *width = ( scale > 0.0 ) ? 1.0 / scale : 0.0;
+
+	if( inversions ) *inversions = numInversions;
+
+}
+
+/// Cycle leader permutation of packed keys by one digit: each word
+/// moves to the head of its digit bucket [head, tail), in place
+static void permuteDigit(uint_64 *p, GLuint *head, const GLuint *tail, GLint shift) {
+
+	const GLuint mask = (1 << PACKED_BITS) - 1;
+
+	for (GLuint d = 0; d <= mask; ++d) {
+		while( head[d] < tail[d] ) {
+			uint_64 v = p[ head[d] ];
+			GLuint vd = (v >> shift) & mask;
+			while( vd != d ) {
+				uint_64 t = p[ head[vd] ];
+				p[ head[vd]++ ] = v;
+				v = t;
+				vd = (v >> shift) & mask;
+			}
+			p[ head[d]++ ] = v;
+		}
+	}
+
+}
+
+/// Packed Sort of one bucket
+void cpuSort::packedSortBucket(uint_64 *p, GLuint n, GLint shift) {
+
+	if( n <= PACKED_CUTOFF ) { ///< Insertion sort of the remaining key bits
+
+		for (GLuint i = 1; i < n; ++i) {
+			uint_64 v = p[i];
+			GLuint j = i;
+			for (; j > 0 && (p[j-1] >> 32) > (v >> 32); --j) p[j] = p[j-1];
+			p[j] = v;
+		}
+
+		return;
+
+	}
+
+	const GLuint numBuckets = 1 << PACKED_BITS;
+	const GLuint mask = numBuckets - 1;
+
+	GLuint head[numBuckets], tail[numBuckets];
+
+	memset( tail, 0, numBuckets * sizeof(GLuint) );
+
+	for (GLuint i = 0; i < n; ++i) ++tail[ (p[i] >> shift) & mask ];
+
+	GLuint sum = 0;
+	for (GLuint d = 0; d < numBuckets; ++d) {
+		head[d] = sum;
+		sum += tail[d];
+		tail[d] = sum;
+	}
+
+	permuteDigit( p, head, tail, shift );
+
+	if( shift == 32 ) return; ///< Lowest key digit done
+
+	GLuint begin = 0;
+	for (GLuint d = 0; d < numBuckets; ++d) {
+		if( tail[d] - begin > 1 ) packedSortBucket( p + begin, tail[d] - begin, shift - PACKED_BITS );
+		begin = tail[d];
+	}
+
+}
+
+/// Packed Sort
+void cpuSort::packedSort(uint_64 *p, GLuint n) {
+
+	const GLuint numBuckets = 1 << PACKED_BITS;
+	const GLuint mask = numBuckets - 1;
+	const GLint shift = 64 - PACKED_BITS;
+
+	if( n < MIN_PER_THREAD ) { packedSortBucket( p, n, shift ); return; }
+
+	/// Parallel count of the first (highest) digit
+	GLuint count[numBuckets], head[numBuckets], tail[numBuckets];
+
+	memset( count, 0, numBuckets * sizeof(GLuint) );
+
+#pragma omp parallel
+	{
+
+		GLuint local[numBuckets];
+
+		memset( local, 0, numBuckets * sizeof(GLuint) );
+
+#pragma omp for nowait
+		for (GLint i = 0; i < (GLint)n; ++i) ++local[ (p[i] >> shift) & mask ];
+
+		for (GLuint d = 0; d < numBuckets; ++d) {
+			if( !local[d] ) continue;
+#pragma omp atomic
+			count[d] += local[d];
+		}
+
+	}
+
+	GLuint sum = 0;
+	for (GLuint d = 0; d < numBuckets; ++d) {
+		head[d] = sum;
+		sum += count[d];
+		tail[d] = sum;
+	}
+
+	permuteDigit( p, head, tail, shift );
+
+	/// Buckets are independent: sort them in parallel
+#pragma omp parallel for schedule(dynamic, 1)
+	for (GLint d = 0; d < (GLint)numBuckets; ++d) {
+		GLuint begin = tail[d] - count[d];
+		if( count[d] > 1 ) packedSortBucket( p + begin, count[d], shift - PACKED_BITS );
+	}
+
+}
+
+/// Compaction
+GLuint cpuSort::compact(GLuint *out, const GLuint *in, GLuint n, const GLubyte *keep, GLuint *threadCount) {
+
+	GLuint kept = 0;
+
+#pragma omp parallel
+	{
+
+		GLuint nt = omp_get_num_threads(), th = omp_get_thread_num();
+		GLuint begin = (GLuint)( (unsigned long long)n * th / nt );
+		GLuint end = (GLuint)( (unsigned long long)n * (th + 1) / nt );
+
+		GLuint count = 0;
+
+		for (GLuint i = begin; i < end; ++i)
+			count += ( keep[ (in) ? in[i] : i ] != 0 );
+
+		threadCount[th] = count;
+
+#pragma omp barrier
+
+		GLuint offset = 0;
+
+		for (GLuint j = 0; j < th; ++j) offset += threadCount[j];
+
+		for (GLuint i = begin; i < end; ++i) {
+			GLuint id = (in) ? in[i] : i;
+			if( keep[id] ) out[ offset++ ] = id;
+		}
+
+#pragma omp single
+		{
+			for (GLuint j = 0; j < nt; ++j) kept += threadCount[j];
+		}
+
+	}
+
+	return kept;
+
+}
@@ -0,0 +1,290 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   frustumCulling : defines a class to build a bounding volume hierarchy
+ *                    over the tetrahedra and to cull the ones outside the
+ *                    view frustum, keeping a list of the tetrahedra in
+ *                    view to be sorted and drawn.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "frustumCulling.h"
+
+#include <cfloat>
+#include <algorithm>
+
+/// ----------------------------------   frustumCulling   ------------------------------------
+
+/// Constructor
+frustumCulling::frustumCulling() :
+	numTets(0), numLevels(0), numLeaves(0),
+	perm(NULL), leafStart(NULL), box(NULL),
+	leafPlanes(NULL), leafKept(NULL), leafIds(NULL),
+	numCulled(0) {
+
+	memset( lastMVP, 0, 16 * sizeof(GLfloat) );
+
+}
+
+/// Destructor
+frustumCulling::~frustumCulling() {
+
+	if( perm ) delete [] perm;
+	if( leafStart ) delete [] leafStart;
+	if( box ) delete [] box;
+	if( leafPlanes ) delete [] leafPlanes;
+	if( leafKept ) delete [] leafKept;
+	if( leafIds ) delete [] leafIds;
+
+}
+
+/// Build hierarchy
+bool frustumCulling::build(const offVol< GLfloat, GLuint >& vol, const centroidStore& c) {
+
+	numTets = vol.numTets;
+
+	if( box ) delete [] box;
+	box = NULL;
+
+	if( !numTets ) return false;
+
+	/// Levels until every leaf has at most BVH_LEAF_SIZE tets
+	numLevels = c.splitLevels( BVH_LEAF_SIZE );
+
+	numLeaves = 1 << numLevels;
+
+	if( perm ) delete [] perm;
+	perm = new GLuint[ numTets ];
+	if( !perm ) return false;
+
+	if( leafStart ) delete [] leafStart;
+	leafStart = new GLuint[ numLeaves + 1 ];
+	if( !leafStart ) return false;
+
+	if( leafPlanes ) delete [] leafPlanes;
+	leafPlanes = new GLubyte[ numLeaves ];
+	if( !leafPlanes ) return false;
+
+	if( leafKept ) delete [] leafKept;
+	leafKept = new GLuint[ numLeaves + 1 ];
+	if( !leafKept ) return false;
+
+	if( leafIds ) delete [] leafIds;
+	leafIds = new GLuint[ numTets ];
+	if( !leafIds ) return false;
+
+	if( !visible.create( numTets ) ) return false;
+
+	/// Balanced split of the centroids, the leaves are the node ranges
+	c.medianSplit( perm, numLevels, NULL, leafStart );
+
+	/// Node boxes: leaves from their tet vertices, then bottom-up
+	box = new GLfloat[ 6 * (2 * numLeaves - 1) ];
+	if( !box ) return false;
+
+	GLfloat *leafBox = box + 6 * (numLeaves - 1);
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (GLint j = 0; j < (GLint)numLeaves; ++j) {
+
+		GLfloat *b = leafBox + 6 * j;
+
+		b[0] = b[1] = b[2] = FLT_MAX;
+		b[3] = b[4] = b[5] = -FLT_MAX;
+
+		for (GLuint i = leafStart[j]; i < leafStart[j + 1]; ++i)
+			for (GLuint v = 0; v < 4; ++v)
+				for (GLuint k = 0; k < 3; ++k) {
+					GLfloat x = vol.vertList[ vol.tetList[ perm[i] ][v] ][k];
+					if( x < b[k] ) b[k] = x;
+					if( x > b[3 + k] ) b[3 + k] = x;
+				}
+
+	}
+
+	for (GLint n = numLeaves - 2; n >= 0; --n) {
+
+		GLfloat *b = box + 6 * n, *l = box + 6 * (2 * n + 1), *r = box + 6 * (2 * n + 2);
+
+		for (GLuint k = 0; k < 3; ++k) {
+			b[k] = std::min( l[k], r[k] );
+			b[3 + k] = std::max( l[3 + k], r[3 + k] );
+		}
+
+	}
+
+	return true;
+
+}
+
+/// Update tets in view
+void frustumCulling::update(const offVol< GLfloat, GLuint >& vol, const GLfloat *mvp, const GLubyte *mask) {
+
+	if( !box ) return;
+
+	memcpy( lastMVP, mvp, 16 * sizeof(GLfloat) );
+
+	/// Frustum planes in object space (clip w +/- x, y, z), inside is positive
+	GLfloat planes[6][4];
+
+	for (GLuint p = 0; p < 6; ++p) {
+		GLuint r = p / 2;
+		GLfloat s = (p % 2) ? -1.0 : 1.0;
+		for (GLuint k = 0; k < 4; ++k)
+			planes[p][k] = mvp[k*4 + 3] + s * mvp[k*4 + r];
+	}
+
+	/// Classify the nodes from the root (stack of node and planes still
+	/// crossed); leaves keep the planes they cross, or BVH_OUTSIDE
+	struct { GLuint node; GLubyte planes; } stack[64];
+	GLint top = 0;
+
+	stack[top].node = 0; stack[top].planes = 0x3F;
+
+	numCulled = 0;
+
+	while( top >= 0 ) {
+
+		GLuint node = stack[top].node;
+		GLubyte crossed = stack[top].planes;
+		--top;
+
+		const GLfloat *b = box + 6 * node;
+
+		bool outside = false;
+
+		for (GLuint p = 0; p < 6 && !outside; ++p) {
+
+			if( !( crossed & (1 << p) ) ) continue;
+
+			/// Box corners farthest along and against the plane normal
+			GLfloat distMax = planes[p][3], distMin = planes[p][3];
+
+			for (GLuint k = 0; k < 3; ++k) {
+				distMax += planes[p][k] * ( (planes[p][k] > 0.0) ? b[3 + k] : b[k] );
+				distMin += planes[p][k] * ( (planes[p][k] > 0.0) ? b[k] : b[3 + k] );
+			}
+
+			if( distMax < 0.0 ) outside = true;
+			else if( distMin >= 0.0 ) crossed &= ~(1 << p); ///< Inside this plane
+
+		}
+
+		GLuint first, last; ///< Leaves of the node
+
+		GLuint level = 0;
+		while( ( (2u << level) - 1 ) <= node ) ++level;
+
+		first = ( node - ( (1 << level) - 1 ) ) << (numLevels - level);
+		last = first + ( numLeaves >> level );
+
+		if( outside || !crossed || level == numLevels ) { ///< Whole subtree classified
+
+			for (GLuint j = first; j < last; ++j)
+				leafPlanes[j] = (outside) ? BVH_OUTSIDE : crossed;
+
+			if( outside ) numCulled += last - first;
+
+			continue;
+
+		}
+
+		++top;
+		stack[top].node = 2 * node + 2; stack[top].planes = crossed;
+		++top;
+		stack[top].node = 2 * node + 1; stack[top].planes = crossed;
+
+	}
+
+	/// Clear the flags of the last update (only the tets in view)
+	visible.clear();
+
+	/// List the tets in view of each leaf at its perm range
+#pragma omp parallel for schedule(dynamic, 1)
+	for (GLint j = 0; j < (GLint)numLeaves; ++j) {
+
+		GLuint kept = 0, begin = leafStart[j], end = leafStart[j + 1];
+		GLubyte crossed = leafPlanes[j];
+
+		if( crossed == BVH_OUTSIDE ) { leafKept[j] = 0; continue; }
+
+		for (GLuint i = begin; i < end; ++i) {
+
+			GLuint t = perm[i];
+
+			if( mask && !mask[t] ) continue;
+
+			/// Outside if all four vertices are outside one plane
+			bool outside = false;
+
+			for (GLuint p = 0; crossed && p < 6 && !outside; ++p) {
+
+				if( !( crossed & (1 << p) ) ) continue;
+
+				outside = true;
+
+				for (GLuint v = 0; v < 4 && outside; ++v) {
+					GLuint x = vol.tetList[t][v];
+					if( planes[p][0] * vol.vertList[x][0] + planes[p][1] * vol.vertList[x][1]
+					    + planes[p][2] * vol.vertList[x][2] + planes[p][3] >= 0.0 )
+						outside = false;
+				}
+
+			}
+
+			if( !outside ) leafIds[ begin + kept++ ] = t;
+
+		}
+
+		leafKept[j] = kept;
+
+	}
+
+	/// Leaf offsets in the list
+	GLuint sum = 0;
+
+	for (GLuint j = 0; j < numLeaves; ++j) {
+		GLuint k = leafKept[j];
+		leafKept[j] = sum;
+		sum += k;
+	}
+
+	leafKept[numLeaves] = sum;
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (GLint j = 0; j < (GLint)numLeaves; ++j) {
+
+		GLuint out = leafKept[j], n = leafKept[j + 1] - out;
+
+		for (GLuint i = 0; i < n; ++i)
+			visible.set( out + i, leafIds[ leafStart[j] + i ] );
+
+	}
+
+	visible.resize( sum );
+
+}
+
+/// Size of frustum culling data
+size_t frustumCulling::sizeOf(void) {
+
+	return ( ( (perm) ? numTets * sizeof(GLuint) : 0 ) + ///< Tets in hierarchy order
+		 ( (leafStart) ? (numLeaves + 1) * sizeof(GLuint) : 0 ) + ///< Leaf ranges
+		 ( (box) ? 6 * (2 * numLeaves - 1) * sizeof(GLfloat) : 0 ) + ///< Node boxes
+		 ( (leafPlanes) ? numLeaves * sizeof(GLubyte) : 0 ) + ///< Leaf planes
+		 ( (leafKept) ? (numLeaves + 1) * sizeof(GLuint) : 0 ) + ///< Leaf offsets
+		 ( (leafIds) ? numTets * sizeof(GLuint) : 0 ) + ///< Leaf lists
+		 ( visible.sizeOf() ) + ///< Tets in view
+		 ( 16 * sizeof(GLfloat) ) + ///< Last frustum
+		 ( 4 * sizeof(GLuint) ) + ///< All GLuints
+		 ( 6 * sizeof(void*) ) ///< All pointers
+		);
+
+}
@@ -16,6 +16,8 @@
 
 #include "hapt.h"
 
+#include <cstring>
+
 /// -----------------------------------   Functions   -------------------------------------
 
 /// Main
@@ -24,6 +26,12 @@ int main(int argc, char** argv) {
 
 	glAppInit(argc, argv);
 
+	/// Compact sort mode: hapt 'file' -c
+	if ( argc == 3 && !strcmp(argv[2], "-c") ) {
+		app.useCompactSort();
+		argc = 2;
+	}
+
 	if ( !app.setup(argc, argv) )
 		return 1;
 
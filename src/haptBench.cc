@@ -0,0 +1,276 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   Sort Benchmark
+ *
+ *   Headless benchmark of the visibility sorters: loads a volume,
+ *   generates reproducible random and orbit views and writes one CSV
+ *   line per sorter and view set with throughput, latency
+ *   percentiles, peak memory and visibility sort error.
+ *
+ * C++ code.
+ *
+ */
+
+/// ----------------------------------   Definitions   ------------------------------------
+
+#include "haptVol.h"
+
+#include <sys/resource.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using std::cerr;
+using std::endl;
+
+/// Default number of random and orbit views
+#define BENCH_RANDOM_VIEWS 64
+#define BENCH_ORBIT_VIEWS 64
+
+/// Orbit tilt around the X axis (in degrees)
+#define BENCH_ORBIT_TILT 30.0
+
+haptVol app(false); ///< Volume (no debug output, stdout is the CSV)
+
+/// -----------------------------------   Functions   -------------------------------------
+
+/// Modelview of a rotation (column-major, volume in front of the camera)
+/// @arg r row-major 3x3 rotation
+/// @arg mv output modelview
+static void rotationMV(const double r[3][3], GLfloat *mv) {
+
+	for (GLuint c = 0; c < 4; ++c)
+		for (GLuint l = 0; l < 4; ++l)
+			mv[c*4 + l] = ( c < 3 && l < 3 ) ? r[l][c] : ( (c == l) ? 1.0 : 0.0 );
+
+	mv[14] = -2.0;
+
+}
+
+/// Random views: uniform random rotations (unit quaternions)
+/// @arg n number of views
+/// @arg views output modelviews (n x 16)
+static void randomViews(GLuint n, GLfloat *views) {
+
+	for (GLuint v = 0; v < n; ++v) {
+
+		double u1 = drand48(), u2 = 2.0 * M_PI * drand48(), u3 = 2.0 * M_PI * drand48();
+
+		double x = sqrt(1.0 - u1) * sin(u2), y = sqrt(1.0 - u1) * cos(u2);
+		double z = sqrt(u1) * sin(u3), w = sqrt(u1) * cos(u3);
+
+		double r[3][3] = {
+			{ 1 - 2*(y*y + z*z), 2*(x*y - z*w), 2*(x*z + y*w) },
+			{ 2*(x*y + z*w), 1 - 2*(x*x + z*z), 2*(y*z - x*w) },
+			{ 2*(x*z - y*w), 2*(y*z + x*w), 1 - 2*(x*x + y*y) } };
+
+		rotationMV(r, views + v*16);
+
+	}
+
+}
+
+/// Orbit views: full turn around the Y axis with a fixed tilt
+/// @arg n number of views
+/// @arg views output modelviews (n x 16)
+static void orbitViews(GLuint n, GLfloat *views) {
+
+	double t = BENCH_ORBIT_TILT * M_PI / 180.0;
+
+	for (GLuint v = 0; v < n; ++v) {
+
+		double a = 2.0 * M_PI * v / n;
+
+		/// Tilt(X) * Turn(Y)
+		double r[3][3] = {
+			{ cos(a), 0.0, sin(a) },
+			{ sin(t) * sin(a), cos(t), -sin(t) * cos(a) },
+			{ -cos(t) * sin(a), sin(t), cos(t) * cos(a) } };
+
+		rotationMV(r, views + v*16);
+
+	}
+
+}
+
+/// Reset the peak resident memory (Linux 4.0 and later)
+static void resetPeakMemory(void) {
+
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+
+	if( !f ) return;
+
+	fputs("5", f);
+	fclose(f);
+
+}
+
+/// Peak resident memory
+/// @return peak resident set size in KB
+static long peakMemory(void) {
+
+	long kb = -1;
+	char line[256];
+
+	FILE *f = fopen("/proc/self/status", "r");
+
+	if( f ) {
+		while( fgets(line, sizeof(line), f) )
+			if( sscanf(line, "VmHWM: %ld", &kb) == 1 ) break;
+		fclose(f);
+	}
+
+	if( kb < 0 ) { ///< Process peak
+		struct rusage ru;
+		getrusage(RUSAGE_SELF, &ru);
+		kb = ru.ru_maxrss;
+	}
+
+	return kb;
+
+}
+
+/// Benchmark one sorter over a set of views, writing one CSV line
+/// @arg s sorter id
+/// @arg setName view set name
+/// @arg n number of views
+/// @arg views modelviews (n x 16)
+/// @arg measureError compute the visibility sort error of each view
+static void benchSorter(sortType s, const char *setName, GLuint n, const GLfloat *views, bool measureError) {
+
+	visibilitySorter *vs = app.getSorters().get(s);
+
+	GLdouble *times = new GLdouble[n];
+
+	resetPeakMemory();
+
+	/// Untimed warm up (first use builds, caches and page faults)
+	app.sort(s, views);
+
+	vs->resetStats();
+
+	GLdouble errArea = 0.0, errFaces = 0.0;
+
+	for (GLuint v = 0; v < n; ++v) {
+
+		app.sort(s, views + v*16);
+
+		times[v] = vs->lastTime();
+
+		if( measureError ) {
+
+			app.computeSortError(s, views + v*16, app.getIds(), app.getDrawCount());
+
+			errArea += app.getSortError(s);
+			errFaces += app.getSortErrorFaces(s);
+
+		}
+
+	}
+
+	long peakKB = peakMemory();
+
+	std::sort(times, times + n);
+
+	GLdouble p50 = times[ (n - 1) / 2 ];
+	GLdouble p99 = times[ std::min( n - 1, (GLuint)ceil(0.99 * n) - 1 ) ];
+
+	GLdouble mean = vs->meanTime();
+
+	printf("\"%s\",%s,%d,%d,%.6lf,%.6lf,%.6lf,%.3lf,%ld,%zu,",
+	       vs->name(), setName, n, app.volume.numTets, mean, p50, p99,
+	       (mean > 0.0) ? app.volume.numTets / mean / 1000000.0 : 0.0,
+	       peakKB, vs->sizeOf());
+
+	if( measureError ) printf("%.6lf,%.6lf\n", errArea / n, errFaces / n);
+	else printf(",\n");
+
+	fflush(stdout);
+
+	delete [] times;
+
+}
+
+/// Main
+
+int main(int argc, char** argv) {
+
+	GLuint numRandom = BENCH_RANDOM_VIEWS, numOrbit = BENCH_ORBIT_VIEWS;
+	long seed = 1;
+	bool measureError = true;
+	const char *only = NULL;
+
+	char *volArgv[2] = { argv[0], NULL };
+
+	for (int a = 1; a < argc; ++a) {
+
+		if( !strcmp(argv[a], "-r") && a + 1 < argc ) numRandom = atoi(argv[++a]);
+		else if( !strcmp(argv[a], "-o") && a + 1 < argc ) numOrbit = atoi(argv[++a]);
+		else if( !strcmp(argv[a], "-s") && a + 1 < argc ) seed = atol(argv[++a]);
+		else if( !strcmp(argv[a], "-m") && a + 1 < argc ) only = argv[++a];
+		else if( !strcmp(argv[a], "-n") ) measureError = false;
+		else if( !strcmp(argv[a], "-c") ) app.useCompactSort();
+		else if( argv[a][0] != '-' && !volArgv[1] ) volArgv[1] = argv[a];
+		else { volArgv[1] = NULL; break; } ///< Show usage
+
+	}
+
+	if( !volArgv[1] ) {
+
+		cerr << "Usage: " << argv[0] << " 'file' [-r views] [-o views] [-s seed] [-m sorter] [-n] [-c]" << endl << endl
+		     << "  Sorts 'file' (see hapt usage) for random and orbit views and writes" << endl
+		     << "  one CSV line per sorter and view set" << endl
+		     << "  |_ -r : number of random views (default " << BENCH_RANDOM_VIEWS << ")" << endl
+		     << "  |_ -o : number of orbit views (default " << BENCH_ORBIT_VIEWS << ")" << endl
+		     << "  |_ -s : random views seed (default 1)" << endl
+		     << "  |_ -m : run only the sorter with this name" << endl
+		     << "  |_ -n : do not measure the sort error" << endl
+		     << "  |_ -c : compact sort mode (only the compact sorter)" << endl;
+
+		return 1;
+
+	}
+
+	int volArgc = 2;
+
+	if( !app.setup(volArgc, volArgv) ) return 1;
+
+	if( !app.sortSetup() ) return 1;
+
+	/// Reproducible views
+	GLfloat *random = new GLfloat[ numRandom * 16 + 16 ];
+	GLfloat *orbit = new GLfloat[ numOrbit * 16 + 16 ];
+
+	srand48( seed );
+
+	randomViews( numRandom, random );
+	orbitViews( numOrbit, orbit );
+
+	printf("sorter,views,num_views,num_tets,mean_s,p50_s,p99_s,mtet_per_s,peak_rss_kb,sorter_bytes,error_area,error_faces\n");
+
+	for (GLuint s = stl_sort; s < app.getSorters().size(); ++s) {
+
+		const visibilitySorter *vs = app.getSorters().get(s);
+
+		if( !vs || ( only && strcmp(vs->name(), only) ) ) continue;
+
+		cerr << "Benchmarking " << vs->name() << "..." << endl;
+
+		if( numRandom ) benchSorter( (sortType)s, "random", numRandom, random, measureError );
+		if( numOrbit ) benchSorter( (sortType)s, "orbit", numOrbit, orbit, measureError );
+
+	}
+
+	delete [] random;
+	delete [] orbit;
+
+	return 0;
+
+}
@@ -0,0 +1,543 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   Batch Renderer
+ *
+ *   Headless rendering of a camera path: loads a volume (with optional
+ *   transfer function and iso-surfaces overrides), renders every frame
+ *   in an offscreen OpenGL context (EGL, or OSMesa when built with
+ *   USE_OSMESA) or with the CPU renderer, writes one image per frame
+ *   and one CSV line of timings per frame.
+ *
+ * C++ code.
+ *
+ */
+
+/// ----------------------------------   Definitions   ------------------------------------
+
+#include "haptVol.h"
+
+#ifdef USE_OSMESA
+#include <GL/osmesa.h> // Off-screen Mesa
+#else
+#include <EGL/egl.h> // EGL pbuffer context
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+
+/// Default image size and output pattern
+#define RENDER_WIDTH 512
+#define RENDER_HEIGHT 512
+#define RENDER_OUTPUT "frame%05d.ppm"
+
+haptVol app(false); ///< Volume (no debug output, stdout is the CSV)
+
+/// -----------------------------------   Functions   -------------------------------------
+
+/// Modelview of a rotation and zoom (column-major)
+/// @arg r row-major 3x3 rotation
+/// @arg zoom uniform scale
+/// @arg mv output modelview
+static void rotationMV(const double r[3][3], double zoom, GLfloat *mv) {
+
+	for (GLuint c = 0; c < 4; ++c)
+		for (GLuint l = 0; l < 4; ++l)
+			mv[c*4 + l] = ( c < 3 && l < 3 ) ? zoom * r[l][c] : ( (c == l) ? 1.0 : 0.0 );
+
+}
+
+/// Read camera path
+///   One command per line ('#' starts a comment):
+///     orbit frames [tilt] [zoom]   full turn around the Y axis, tilted
+///                                  around the X axis (in degrees)
+///     matrix m0 ... m15            one frame, column-major modelview
+/// @arg fn camera path file name
+/// @arg views output modelviews (16 per frame)
+/// @return true if it succeed
+static bool readPath(const char *fn, std::vector< GLfloat >& views) {
+
+	std::ifstream in(fn);
+
+	if( in.fail() ) return false;
+
+	string line;
+	GLuint lineNum = 0;
+
+	while( getline(in, line) ) {
+
+		++lineNum;
+
+		string::size_type c = line.find('#');
+		if( c != string::npos ) line.erase(c);
+
+		std::istringstream ss(line);
+		string cmd;
+
+		if( !(ss >> cmd) ) continue;
+
+		if( cmd == "orbit" ) {
+
+			GLint n = 0;
+			double tilt = 0.0, zoom = 1.0;
+
+			ss >> n;
+			if( !(ss >> tilt) ) tilt = 0.0;
+			else if( !(ss >> zoom) ) zoom = 1.0;
+
+			if( n <= 0 ) {
+				cerr << fn << ":" << lineNum << ": orbit needs a number of frames" << endl;
+				return false;
+			}
+
+			double t = tilt * M_PI / 180.0;
+
+			for (GLint v = 0; v < n; ++v) {
+
+				double a = 2.0 * M_PI * v / n;
+
+				/// Tilt(X) * Turn(Y)
+				double r[3][3] = {
+					{ cos(a), 0.0, sin(a) },
+					{ sin(t) * sin(a), cos(t), -sin(t) * cos(a) },
+					{ -cos(t) * sin(a), sin(t), cos(t) * cos(a) } };
+
+				GLfloat mv[16];
+				rotationMV(r, zoom, mv);
+				views.insert(views.end(), mv, mv + 16);
+
+			}
+
+		} else if( cmd == "matrix" ) {
+
+			GLfloat mv[16];
+
+			for (GLuint i = 0; i < 16; ++i) {
+				if( !(ss >> mv[i]) ) {
+					cerr << fn << ":" << lineNum << ": matrix needs 16 values" << endl;
+					return false;
+				}
+			}
+
+			views.insert(views.end(), mv, mv + 16);
+
+		} else {
+
+			cerr << fn << ":" << lineNum << ": unknown command " << cmd << endl;
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+/// Check output pattern
+///   Exactly one integer conversion (flags, width and precision allowed,
+///   no length modifier nor '*') for the frame number; '%%' is a literal '%'
+/// @arg pattern output file name pattern
+/// @return true if it is valid
+static bool validPattern(const char *pattern) {
+
+	GLuint conversions = 0;
+
+	for (const char *p = pattern; *p; ++p) {
+
+		if( *p != '%' ) continue;
+
+		++p;
+
+		if( *p == '%' ) continue;
+
+		while( *p && strchr("-+ #0", *p) ) ++p;
+		while( *p >= '0' && *p <= '9' ) ++p;
+
+		if( *p == '.' ) {
+			++p;
+			while( *p >= '0' && *p <= '9' ) ++p;
+		}
+
+		if( !*p || !strchr("diuoxX", *p) ) return false;
+
+		++conversions;
+
+	}
+
+	return conversions == 1;
+
+}
+
+/// Offscreen OpenGL context
+///   A pbuffer (EGL) or a client buffer (OSMesa) of the image size
+/// @arg w, h image size
+/// @return true if it succeed
+static bool createContext(GLuint w, GLuint h) {
+
+#ifdef USE_OSMESA
+
+	OSMesaContext ctx = OSMesaCreateContextExt(OSMESA_RGBA, 24, 8, 0, NULL);
+
+	if( !ctx ) return false;
+
+	static std::vector< GLubyte > buffer;
+	buffer.resize( w * h * 4 );
+
+	return OSMesaMakeCurrent(ctx, &buffer[0], GL_UNSIGNED_BYTE, w, h);
+
+#else
+
+	EGLDisplay dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+
+	if( dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor) ) return false;
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_STENCIL_SIZE, 8, ///< Front-to-back termination mask
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE };
+
+	EGLConfig config;
+	EGLint numConfigs;
+
+	if( !eglChooseConfig(dpy, configAttribs, &config, 1, &numConfigs) || numConfigs < 1 ) return false;
+
+	const EGLint pbufferAttribs[] = { EGL_WIDTH, (EGLint)w, EGL_HEIGHT, (EGLint)h, EGL_NONE };
+
+	EGLSurface surface = eglCreatePbufferSurface(dpy, config, pbufferAttribs);
+
+	if( surface == EGL_NO_SURFACE ) return false;
+
+	/// Desktop OpenGL (compatibility profile, fixed-function matrices)
+	if( !eglBindAPI(EGL_OPENGL_API) ) return false;
+
+	EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, NULL);
+
+	if( ctx == EGL_NO_CONTEXT ) return false;
+
+	return eglMakeCurrent(dpy, surface, surface, ctx);
+
+#endif
+
+}
+
+/// Write a binary PPM image
+/// @arg fn file name
+/// @arg w, h image size
+/// @arg rgb pixels (bottom row first, as glReadPixels)
+/// @return true if it succeed
+static bool writePPM(const char *fn, GLuint w, GLuint h, const GLubyte *rgb) {
+
+	FILE *f = fopen(fn, "wb");
+
+	if( !f ) return false;
+
+	fprintf(f, "P6\n%d %d\n255\n", w, h);
+
+	for (GLint y = h - 1; y >= 0; --y)
+		fwrite(rgb + y * w * 3, 1, w * 3, f);
+
+	return fclose(f) == 0;
+
+}
+
+/// Elapsed time
+/// @arg start start time
+/// @return seconds since start
+static GLdouble elapsed(const struct timeval& start) {
+
+	struct timeval now;
+	gettimeofday(&now, 0);
+
+	return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec)/1000000.0;
+
+}
+
+/// Main
+
+int main(int argc, char** argv) {
+
+	GLuint width = RENDER_WIDTH, height = RENDER_HEIGHT;
+	const char *pathFile = NULL, *output = RENDER_OUTPUT;
+	const char *tfFile = NULL, *isoFile = NULL, *sorter = NULL;
+	GLfloat brightness = 1.0;
+	drawType mode = dvr;
+	bool software = false;
+	GLuint tileSize = 0; ///< Sort-first tile size (0 is off)
+	bool cullEmpty = false; ///< Cull the tets with no opacity
+	bool cullFrustum = false; ///< Cull the tets outside the view frustum
+	GLfloat termination = 0.0; ///< Front-to-back termination opacity (0 is back-to-front)
+
+	char *volArgv[2] = { argv[0], NULL };
+
+	for (int a = 1; a < argc; ++a) {
+
+		if( !strcmp(argv[a], "-p") && a + 1 < argc ) pathFile = argv[++a];
+		else if( !strcmp(argv[a], "-o") && a + 1 < argc ) output = argv[++a];
+		else if( !strcmp(argv[a], "-W") && a + 1 < argc ) width = atoi(argv[++a]);
+		else if( !strcmp(argv[a], "-H") && a + 1 < argc ) height = atoi(argv[++a]);
+		else if( !strcmp(argv[a], "-t") && a + 1 < argc ) tfFile = argv[++a];
+		else if( !strcmp(argv[a], "-i") && a + 1 < argc ) isoFile = argv[++a];
+		else if( !strcmp(argv[a], "-b") && a + 1 < argc ) brightness = atof(argv[++a]);
+		else if( !strcmp(argv[a], "-m") && a + 1 < argc ) sorter = argv[++a];
+		else if( !strcmp(argv[a], "-d") && a + 1 < argc ) {
+			++a;
+			if( !strcmp(argv[a], "iso") ) mode = isos;
+			else if( !strcmp(argv[a], "dvr_iso") ) mode = dvr_isos;
+			else mode = dvr;
+		}
+		else if( !strcmp(argv[a], "-f") && a + 1 < argc ) tileSize = atoi(argv[++a]);
+		else if( !strcmp(argv[a], "-e") && a + 1 < argc ) termination = atof(argv[++a]);
+		else if( !strcmp(argv[a], "-x") ) cullEmpty = true;
+		else if( !strcmp(argv[a], "-v") ) cullFrustum = true;
+		else if( !strcmp(argv[a], "-s") ) software = true;
+		else if( !strcmp(argv[a], "-c") ) app.useCompactSort();
+		else if( argv[a][0] != '-' && !volArgv[1] ) volArgv[1] = argv[a];
+		else { volArgv[1] = NULL; break; } ///< Show usage
+
+	}
+
+	if( !volArgv[1] || !pathFile || width == 0 || height == 0 ) {
+
+		cerr << "Usage: " << argv[0] << " 'file' -p path [-o pattern] [-W width] [-H height]" << endl
+		     << "       [-t tf] [-i iso] [-b brightness] [-d dvr|iso|dvr_iso] [-m sorter] [-f tile] [-e opacity] [-x] [-v] [-s] [-c]" << endl << endl
+		     << "  Renders 'file' (see hapt usage) for each frame of the camera path" << endl
+		     << "  without a window, writing one image and one CSV line per frame" << endl
+		     << "  |_ -p : camera path file, one command per line:" << endl
+		     << "  |        orbit frames [tilt] [zoom]  or  matrix m0 ... m15" << endl
+		     << "  |_ -o : output pattern with the frame number (default " << RENDER_OUTPUT << ")" << endl
+		     << "  |_ -W, -H : image size (default " << RENDER_WIDTH << " x " << RENDER_HEIGHT << ")" << endl
+		     << "  |_ -t : transfer function file (instead of 'file'.tf)" << endl
+		     << "  |_ -i : iso-surfaces file (instead of 'file'.iso)" << endl
+		     << "  |_ -b : brightness (default 1)" << endl
+		     << "  |_ -d : draw mode (default dvr)" << endl
+		     << "  |_ -m : sorter name (default CPU Radix)" << endl
+		     << "  |_ -f : sort-first mode with tiles of the given size in pixels" << endl
+		     << "  |_ -e : front-to-back, pixels stop at the given opacity (e.g. 0.99)" << endl
+		     << "  |_ -x : cull the tets with no opacity under the transfer function (DVR)" << endl
+		     << "  |_ -v : cull the tets outside the view frustum (zoomed paths)" << endl
+		     << "  |_ -s : CPU renderer (DVR, no OpenGL context)" << endl
+		     << "  |_ -c : compact sort mode" << endl;
+
+		return 1;
+
+	}
+
+	if( !validPattern(output) ) {
+		cerr << "Output pattern " << output << " needs exactly one integer conversion (e.g. " << RENDER_OUTPUT << ")" << endl;
+		return 1;
+	}
+
+	std::vector< GLfloat > views;
+
+	if( !readPath(pathFile, views) ) {
+		cerr << "Could not read camera path " << pathFile << endl;
+		return 1;
+	}
+
+	GLuint numFrames = views.size() / 16;
+
+	int volArgc = 2;
+
+	if( !app.setup(volArgc, volArgv) ) return 1;
+
+	/// Overrides (before the textures are created)
+	if( tfFile && !app.volume.readTF(tfFile) ) {
+		cerr << "Could not read transfer function " << tfFile << endl;
+		return 1;
+	}
+
+	if( isoFile && !app.volume.readISO(isoFile) ) {
+		cerr << "Could not read iso-surfaces " << isoFile << endl;
+		return 1;
+	}
+
+	if( !software && !createContext(width, height) ) {
+		cerr << "No offscreen OpenGL context, using the CPU renderer" << endl;
+		software = true;
+	}
+
+	if( software && mode != dvr ) cerr << "The CPU renderer draws only DVR" << endl;
+
+	if( software && termination > 0.0 ) cerr << "The CPU renderer composites back-to-front" << endl;
+
+	if( software && tileSize ) cerr << "The CPU renderer draws a global order (no sort-first)" << endl;
+
+	if( software ) {
+
+		if( !app.sortSetup() ) return 1;
+
+		app.setSoftwareBrightness( brightness );
+
+	} else {
+
+		if( !app.glSetup() ) return 1;
+
+		app.switchShaders( mode );
+
+		if( mode != isos ) app.refreshTFandBrightness( brightness );
+
+		glViewport(0, 0, width, height);
+
+		/// Same projection of the viewer
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glOrtho(-1.0, 1.0, -1.0, 1.0, -1.0, 1.0);
+
+		glMatrixMode(GL_MODELVIEW);
+
+		if( tileSize ) { ///< Tile lists sorted on their own
+
+			app.setTileSize( tileSize );
+
+			if( !app.useSortFirst() ) cerr << "Sort-first mode not available in compact mode" << endl;
+
+		}
+
+		if( termination > 0.0 ) { ///< Early opacity termination
+
+			app.setTerminationOpacity( termination );
+
+			if( !app.useFrontToBack() ) cerr << "No alpha or stencil bits, compositing back-to-front" << endl;
+
+		}
+
+	}
+
+	if( cullEmpty && !app.useEmptyCulling() ) cerr << "Empty-tet culling not available in compact mode" << endl;
+
+	if( cullEmpty && app.emptyCullingOn() )
+		cerr << app.getVisibleTets() << " of " << app.volume.numTets << " tets visible" << endl;
+
+	if( cullFrustum && app.compactSort() ) cerr << "View-frustum culling not available in compact mode" << endl;
+
+	app.useFrustumCulling( cullFrustum );
+
+	if( !software && mode == isos && app.isoIndexOn() )
+		cerr << app.getActiveTets() << " of " << app.volume.numTets << " tets crossed by the iso-surfaces" << endl;
+
+	/// Sort method
+	GLint s = app.getSorters().findName( sorter ? sorter : "CPU Radix" );
+
+	if( s < 0 && sorter ) {
+		cerr << "No sorter named " << sorter << endl;
+		return 1;
+	}
+
+	for (GLuint i = stl_sort; s < 0 && i < app.getSorters().size(); ++i)
+		if( app.getSorters().get(i) ) s = i;
+
+	if( s < 0 ) return 1;
+
+	std::vector< GLubyte > rgb( width * height * 3 );
+
+	char fn[1024];
+
+	GLdouble sumTotal = 0.0;
+
+	printf("frame,file,sort_s,draw_s,read_s,write_s,total_s,tets\n");
+
+	for (GLuint f = 0; f < numFrames; ++f) {
+
+		const GLfloat *mv = &views[f * 16];
+
+		GLdouble sortTime, drawTime, readTime, writeTime;
+
+		struct timeval start, step;
+		gettimeofday(&start, 0);
+
+		if( software ) {
+
+			app.sort( (sortType)s, mv );
+
+			sortTime = elapsed(start);
+			gettimeofday(&step, 0);
+
+			/// glOrtho(-1, 1, -1, 1, -1, 1) * modelview
+			GLfloat mvp[16];
+
+			for (GLuint k = 0; k < 16; ++k) mvp[k] = ( k % 4 == 2 ) ? -mv[k] : mv[k];
+
+			app.softwareDraw( width, height, mvp );
+
+			drawTime = elapsed(step);
+			gettimeofday(&step, 0);
+
+			const GLfloat *img = app.getSoftwareRenderer().image();
+
+			for (GLuint p = 0; p < width * height; ++p)
+				for (GLuint k = 0; k < 3; ++k) {
+					GLfloat c = img[p*4 + k];
+					rgb[p*3 + k] = (GLubyte)( ( c <= 0.0 ) ? 0 : ( ( c >= 1.0 ) ? 255 : c * 255.0 + 0.5 ) );
+				}
+
+			readTime = elapsed(step);
+
+		} else {
+
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			glLoadMatrixf( mv );
+
+			app.sort( sortTime, (sortType)s );
+
+			app.draw( drawTime );
+
+			gettimeofday(&step, 0);
+
+			glFinish();
+
+			drawTime += elapsed(step);
+			gettimeofday(&step, 0);
+
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &rgb[0]);
+
+			readTime = elapsed(step);
+
+		}
+
+		gettimeofday(&step, 0);
+
+		snprintf(fn, sizeof(fn), output, f);
+
+		if( !writePPM(fn, width, height, &rgb[0]) ) {
+			cerr << "Could not write " << fn << endl;
+			return 1;
+		}
+
+		writeTime = elapsed(step);
+
+		GLdouble total = elapsed(start);
+		sumTotal += total;
+
+		printf("%d,\"%s\",%.6lf,%.6lf,%.6lf,%.6lf,%.6lf,%u\n", f, fn,
+		       sortTime, drawTime, readTime, writeTime, total, app.getDrawCount());
+
+		fflush(stdout);
+
+	}
+
+	if( numFrames )
+		cerr << numFrames << " frames, " << app.getSorterName( (sortType)s ) << ", "
+		     << ( software ? "CPU renderer" : "OpenGL" ) << ", mean "
+		     << sumTotal / numFrames << " s/frame" << endl;
+
+	return 0;
+
+}
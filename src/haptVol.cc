@@ -33,6 +33,10 @@
 
 #include <assert.h>
 
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
 using std::setprecision;
 using std::cerr;
 using std::cout;
@@ -56,46 +60,122 @@ haptVol::haptVol( bool _d ) :
 	appVol(_d),
 	haptShader(NULL),
 	ids(NULL),
-	dag(NULL),
-	visited(NULL),
-	visitedCycle(NULL),
+	mpvoState(NULL),
+	DFScount(0),
+	DFScycles(0),
+	dagRevisited(0),
+	mpvoCount(NULL),
+	mpvoQueue(NULL),
+	mpvoThreads(1),
+	mpvoOffsets(NULL),
+	mpvoNext(NULL),
 	useBufObj(true),
 	useLight(true),
 	drawMode(dvr),
 	centroidSorted(NULL),
-	centroidList(NULL),
+	depthKeys(NULL),
+	prevOrder(NULL),
+	prevOrderValid(false),
+	lastRepaired(false),
+	maxDisorder(4.0),
+	bucketBits(12),
+	bucketWidth(0.0),
+	bucketInversions(0),
+	pipelined(false),
+	syncObjects(false),
+	pipeDraw(-1),
+	lastViewValid(false),
+	lastViewSort(none),
+	viewTolerance(0.0),
+	sortSkipped(false),
+	sortCacheHits(0),
+	lastSortTime(0.0), sortSkippedTime(0.0),
+	measureError(false),
+	compactMode(false),
+	packedIds(NULL),
+	cudaReady(false),
+	sortFirst(false),
+	tileBufObject(0),
+	frontToBack(false),
+	terminationOpacity(0.99),
+	cullEmpty(false),
+	drawCount(0),
+	indexIsos(true),
+	cullFrustum(false),
+	orderCacheTried(false),
+	lastCachedDir(0),
 	orderTableTex(0), tfanOrderTableTex(0),
 	tfTex(0), psiGammaTableTex(0),
+	softBrightness(1.0),
 	backGround(WHITE) {
+
+	for (GLuint i = 0; i < max_sort_types; ++i) {
+		sortErrorArea[i] = -1.0;
+		sortErrorFaces[i] = -1.0;
+	}
+
+	for (GLuint i = 0; i < 4; ++i) bufArray[i] = NULL;
+
+	for (GLuint i = 0; i < 5; ++i) bufObject[i] = 0;
+
+	for (GLuint k = 0; k < NUM_SORT_SLOTS; ++k) { pipeBufObject[k] = 0; pipeFence[k] = NULL; }
+
+	for (GLuint i = 0; i < 16; ++i) sortProj[i] = (i % 5 == 0) ? 1.0 : 0.0;
+
 }
 
 /// Destructor
 haptVol::~haptVol() {
 
+	pipeline.stop(); ///< The worker uses the arrays below
+
 	if( haptShader ) delete haptShader;
 
 	if( ids ) delete [] ids;
 
-	if( dag ) delete [] dag;
+	if( mpvoState ) delete [] mpvoState;
+
+	if( mpvoCount ) delete [] mpvoCount;
 
-	if( visited ) delete [] visited;
+	if( mpvoQueue ) delete [] mpvoQueue;
 
-	if( visitedCycle ) delete [] visitedCycle;
+	if( mpvoOffsets ) delete [] mpvoOffsets;
+
+	if( mpvoNext ) delete [] mpvoNext;
 	
 	for (uint i = 0; i < 4; ++i) if( bufArray[i] ) delete [] bufArray[i];
 
 	if( centroidSorted ) delete [] centroidSorted;
 
-	if( centroidList ) delete [] centroidList;
+	if( depthKeys ) delete [] depthKeys;
+
+	if( prevOrder ) delete [] prevOrder;
+
+	if( packedIds ) delete [] packedIds;
+
+	if( tfTex ) { ///< OpenGL objects (none after a sort-only setup)
+
+		glDeleteTextures(1, &orderTableTex);
+		glDeleteTextures(1, &tfanOrderTableTex);
+		glDeleteTextures(1, &tfTex);
+		glDeleteTextures(1, &psiGammaTableTex);
+
+	}
+
+	if( bufObject[0] ) glDeleteBuffers(5, &bufObject[0]);
+
+	if( tileBufObject ) glDeleteBuffers(1, &tileBufObject);
+
+	if( pipeBufObject[0] ) { ///< Still pipelined
 
-	glDeleteTextures(1, &orderTableTex);
-	glDeleteTextures(1, &tfanOrderTableTex);
-	glDeleteTextures(1, &tfTex);
-	glDeleteTextures(1, &psiGammaTableTex);
+		for (GLuint k = 0; k < NUM_SORT_SLOTS; ++k)
+			if( pipeFence[k] ) glDeleteSync( (GLsync)pipeFence[k] );
 
-	glDeleteBuffers(5, &bufObject[0]);
+		glDeleteBuffers(NUM_SORT_SLOTS, pipeBufObject);
 
-	cleanCUDA();
+	}
+
+	if( cudaReady ) cleanCUDA();
 
 }
 
@@ -137,7 +217,9 @@ bool haptVol::glSetup() {
 		if( debug ) cout << "done!" << endl;
 
 		if( debug ) cout << endl << "# Memory Size = " << setprecision(4)
-				 << this->sizeOf() / 1000000.0 << " MB " << endl << endl;
+				 << this->sizeOf() / 1000000.0 << " MB " << endl
+				 << "# Sort Size = " << setprecision(4)
+				 << sortSizeOf() / (GLdouble)volume.numTets << " B/tet" << endl << endl;
 		
 
 		switchShaders(dvr);
@@ -159,18 +241,98 @@ bool haptVol::glSetup() {
 }
 
 /// Size of Geometry PT Volume (OpenGL in CPU)
-int haptVol::sizeOf(void) {
+size_t haptVol::sizeOf(void) {
 
   return ( ( (haptShader) ? haptShader->size_of() : 0 ) + ///< HAPT Shader
 		   ( (centroidSorted) ? volume.numTets * sizeof(tetCentroid) : 0 ) + ///< Tet Centroids
-		   ( (centroidList) ? volume.numTets * sizeof(vec3) : 0 ) + ///< Tetrahedron centroid list
-		   ( 9 * sizeof(GLuint) ) + ///< All GLuints
-		   ( 5 * sizeof(void*) ) + ///< All pointers
+		   ( (depthKeys) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Centroid Z keys
+		   ( (prevOrder) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Previous frame order
+		   ( (mpvoState) ? volume.numTets * sizeof(GLubyte) : 0 ) + ///< MPVO state bits
+		   ( faceBins.sizeOf() ) + ///< Incremental MPVO face bins
+		   ( (mpvoCount) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Parallel MPVO successor counts
+		   ( (mpvoQueue) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Parallel MPVO level queue
+		   ( (mpvoOffsets) ? (mpvoThreads + 1) * sizeof(GLuint) : 0 ) + ///< Parallel MPVO thread offsets
+		   ( (mpvoNext) ? ( (size_t)4 * volume.numTets + 8 * mpvoThreads ) * sizeof(GLuint) : 0 ) + ///< Parallel MPVO next levels
+		   ( cpuSorter.sizeOf() ) + ///< CPU sort scratch arrays
+		   ( sorters.sizeOf( num_sort_types ) ) + ///< Sorter registry and plug-in sorters data
+		   ( pipeline.sizeOf() ) + ///< Sort pipeline order slots
+		   ( bricks.sizeOf() ) + ///< Spatial bricks
+		   ( spatialTree.sizeOf() ) + ///< k-d tree
+		   ( viewOrders.sizeOf() ) + ///< View-direction order cache
+		   ( softRenderer.sizeOf() ) + ///< CPU renderer
+		   ( tiles.sizeOf() ) + ///< Sort-first screen tiles
+		   ( culling.sizeOf() ) + ///< Empty-tet culling
+		   ( isoIndex.sizeOf() ) + ///< Iso-surface active-cell index
+		   ( frustum.sizeOf() ) + ///< View-frustum culling hierarchy
+		   ( centroids.sizeOf() ) + ///< Tetrahedron centroids (SoA)
+		   ( qCentroids.sizeOf() ) + ///< Quantized centroids (compact)
+		   ( (packedIds) ? volume.numTets * sizeof(uint_64) : 0 ) + ///< Packed keys and ids (compact)
+		   ( (ids) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Ids in CPU
+		   ( (cudaReady) ? sizeOfCUDA() : 0 ) + ///< centroid.cuh centroids copy and sort arrays
+		   ( 12 * sizeof(GLuint) ) + ///< All GLuints
+		   ( 10 * sizeof(void*) ) + ///< All pointers
 		   ( PSI_GAMMA_SIZE_BACK * PSI_GAMMA_SIZE_FRONT * sizeof(float) ) ///< Psi Gamma Table
 		);
 
 }
 
+/// Size of sort bookkeeping
+size_t haptVol::sortSizeOf(void) {
+
+	return ( ( (centroidSorted) ? volume.numTets * sizeof(tetCentroid) : 0 ) + ///< Tet Centroids
+		 ( (depthKeys) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Centroid Z keys
+		 ( (prevOrder) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Previous frame order
+		 ( (mpvoState) ? volume.numTets * sizeof(GLubyte) : 0 ) + ///< MPVO state bits
+		 ( (mpvoCount) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Parallel MPVO successor counts
+		 ( (mpvoQueue) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< MPVO level queue
+		 ( (mpvoOffsets) ? (mpvoThreads + 1) * sizeof(GLuint) : 0 ) + ///< Parallel MPVO thread offsets
+		 ( (mpvoNext) ? (4 * volume.numTets + 8 * mpvoThreads) * sizeof(GLuint) : 0 ) + ///< Parallel MPVO next levels
+		 ( (ids) ? volume.numTets * sizeof(GLuint) : 0 ) + ///< Ids in CPU
+		 ( cpuSorter.sizeOf() ) + ///< CPU sort scratch arrays
+		 ( sorters.sizeOf( num_sort_types ) ) + ///< Sorter registry and plug-in sorters data
+		 ( bricks.sizeOf() ) + ///< Spatial bricks
+		 ( tiles.sizeOf() ) + ///< Sort-first screen tiles
+		 ( culling.sizeOf() ) + ///< Empty-tet culling
+		 ( isoIndex.sizeOf() ) + ///< Iso-surface active-cell index
+		 ( frustum.sizeOf() ) + ///< View-frustum culling hierarchy
+		 ( centroids.sizeOf() ) + ///< Tetrahedron centroids (SoA)
+		 ( qCentroids.sizeOf() ) + ///< Quantized centroids (compact)
+		 ( (packedIds) ? volume.numTets * sizeof(uint_64) : 0 ) + ///< Packed keys and ids (compact)
+		 ( (cudaReady) ? sizeOfCUDA() : 0 ) ///< centroid.cuh centroids copy and sort arrays
+		);
+
+}
+
+/// Size of a sort method data
+size_t haptVol::sortMethodSizeOf(sortType _sT) {
+
+	GLuint nT = volume.numTets;
+
+	size_t keys = ( (depthKeys) ? nT * sizeof(GLuint) : 0 ) + cpuSorter.sizeOf(); ///< Centroid Z keys and scratch arrays
+	size_t sorted = ( (centroidSorted) ? nT * sizeof(tetCentroid) : 0 ); ///< Tet centroids (id, z)
+	size_t dfs = ( (mpvoState) ? nT * sizeof(GLubyte) : 0 ) + ///< MPVO state bits
+		( (mpvoQueue) ? nT * sizeof(GLuint) : 0 ); ///< DFS stack (level queue in parallel)
+
+	switch( _sT ) {
+	case stl_sort: return sorted + cpuSorter.sizeOf();
+	case gpu_bitonic: case gpu_quick: return ( (cudaReady) ? sizeOfCUDA() : 0 ); ///< centroid.cuh centroids copy and sort arrays
+	case mpvo: return dfs + sorted + cpuSorter.sizeOf();
+	case mpvo_incremental: return dfs + sorted + cpuSorter.sizeOf() + faceBins.sizeOf();
+	case mpvo_parallel: return dfs + sorted + cpuSorter.sizeOf() +
+			( (mpvoCount) ? nT * sizeof(GLuint) : 0 ) + ///< Successor counts
+			( (mpvoOffsets) ? (mpvoThreads + 1) * sizeof(GLuint) : 0 ) + ///< Thread offsets
+			( (mpvoNext) ? ( (size_t)4 * nT + 8 * mpvoThreads ) * sizeof(GLuint) : 0 ); ///< Next levels
+	case cpu_radix: case cpu_bucket: return keys;
+	case cpu_incremental: return keys + ( (prevOrder) ? nT * sizeof(GLuint) : 0 );
+	case cpu_cached: return keys + ( (prevOrder) ? nT * sizeof(GLuint) : 0 ) + viewOrders.sizeOf();
+	case kd_tree: return spatialTree.sizeOf();
+	case brick_sort: return ( bricks.valid() ) ? sorted + bricks.sizeOf() : 0; ///< Built on first use
+	case cpu_compact: return qCentroids.sizeOf() + ( (packedIds) ? nT * sizeof(uint_64) : 0 ) + cpuSorter.sizeOf();
+	default: return 0;
+	}
+
+}
+
 /// Normalize from range [-1, 1]
 void haptVol::normalize(void) {
 
@@ -191,13 +353,7 @@ bool haptVol::createArrays(void) {
 
 	GLuint nT = volume.numTets;
 
-	ids = new GLuint[nT];
-
-	dag = new ivec4[nT];
-
-	visited = new bool[nT];
-
-	visitedCycle = new bool[nT];
+	if( !createSortArrays( !compactMode ) ) return false;
 
 	for (GLuint j = 0; j < 4; ++j)
 		bufArray[j] = new GLfloat[nT * 4];
@@ -222,6 +378,13 @@ bool haptVol::createArrays(void) {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+	if( compactMode ) { ///< Vertices are only drawn from the buffer objects
+		for (GLuint j = 0; j < 4; ++j) {
+			delete [] bufArray[j];
+			bufArray[j] = NULL;
+		}
+	}
+
 	return true;
 
 }
@@ -231,6 +394,19 @@ bool haptVol::createCentroidSorts(void) {
 
 	GLuint i, nT = volume.numTets;
 
+	if( compactMode ) {
+
+		/// Quantized centroids and packed keys (compact sort only)
+		if( !qCentroids.build(volume) ) return false;
+
+		if( packedIds ) delete [] packedIds;
+		packedIds = new uint_64[nT];
+		if( !packedIds ) return false;
+
+		return true;
+
+	}
+
 	/// Centroid sorted (stl)
 	if( centroidSorted ) delete [] centroidSorted;
 	centroidSorted = new tetCentroid[nT];
@@ -243,43 +419,50 @@ bool haptVol::createCentroidSorts(void) {
 
 	}
 
-	/// Allocating memory for centroids
-	if( centroidList ) delete [] centroidList;
-	centroidList = new vec3[ nT ];
-	if( !centroidList ) return false;
+	/// Centroid Z keys and scratch arrays (cpu radix)
+	if( depthKeys ) delete [] depthKeys;
+	depthKeys = new GLuint[nT];
+	if( !depthKeys ) return false;
 
-	/// Compute the centroid of each tetrahedron
-	for (GLuint i = 0; i < nT; ++i) {
+	if( !cpuSorter.init(nT) ) return false;
 
-		centroidList[i] = ( volume.vertList[ volume.tetList[i][0] ].xyz()
-				    + volume.vertList[ volume.tetList[i][1] ].xyz()
-				    + volume.vertList[ volume.tetList[i][2] ].xyz()
-				    + volume.vertList[ volume.tetList[i][3] ].xyz() ) / 4.0;
+	/// Previous frame order (cpu incremental)
+	if( prevOrder ) delete [] prevOrder;
+	prevOrder = new GLuint[nT];
+	if( !prevOrder ) return false;
 
-	}
+	prevOrderValid = false;
 
-	/// Initializing CUDA environment
+	/// Compute the centroid of each tetrahedron (SoA)
+	if( !centroids.build(volume) ) return false;
 
-	if( debug ) cout << "CUDA Initialization... " << flush;
+	/// Scalar range of each tet (empty-tet culling)
+	if( !culling.build(volume) ) return false;
 
-	float *h_centroidList;
-	h_centroidList = new float[ nT*4 ];
-	if( !h_centroidList ) return false;
+	/// Interval tree of the scalar ranges (iso-surface active cells)
+	if( !isoIndex.build(volume) ) return false;
 
-	for (GLuint i = 0; i < nT; ++i) {
+	activeIsoCells();
 
-		for (GLuint j = 0; j < 3; ++j)
-			h_centroidList[ i*4 + j ] = centroidList[i][j];
+	/// Bounding volume hierarchy (view-frustum culling)
+	if( !frustum.build(volume, centroids) ) return false;
 
-		h_centroidList[ i*4 + 3 ] = 1.0;
+	/// Initializing CUDA environment (same SoA centroids, on the
+	/// CPU when built with NO_CUDA), only with a device: the GPU
+	/// sorts are not registered otherwise
 
-	}
+	if( numDevicesCUDA() > 0 ) {
+
+		if( debug ) cout << "CUDA Initialization... " << flush;
+
+		initCUDA( centroids.xList(), centroids.yList(), centroids.zList(), nT );
 
-	initCUDA( h_centroidList, nT );
+		cudaReady = true;
 
-	delete [] h_centroidList;
+		if( debug ) cout << "done!" << endl;
 
-	if( debug ) cout << "done!" << endl;
+	} else
+		cerr << "No CUDA device, GPU sorts disabled" << endl;
 
 	return true;
 
@@ -403,71 +586,80 @@ bool haptVol::createShaders(void) {
 }
 
 /// Depth-First-Search
-void haptVol::DFS( GLuint id ){
+void haptVol::DFS( GLuint root, GLuint *out ){
 
-  if (visited[id] == true)
+  if (mpvoState[root] & MPVO_VISITED)
 	return;
 
-  visited[id] = true;
-  visitedCycle[id] = true;
-  GLuint adjId = 0;
+  // explicit stack of the cells being traversed (each cell is pushed once)
+  GLuint *stack = mpvoQueue;
+  GLuint top = 0;
 
-  // for each adjacent tet
-  for (GLuint j = 0; j < 4; j++) {
-	adjId = volume.conTet[id][j];
+  mpvoState[root] = (mpvoState[root] & MPVO_DAG_MASK) | MPVO_VISITED | MPVO_ONSTACK;
+  stack[top++] = root;
 
-	// not boundary adjacency (index is current)
-	if ((adjId != id)) {
+  while (top > 0) {
 
-	  // check if predecessor (incoming arrow)
-	  if (dag[id][j] == 1) {
-		if (!visited[adjId]) {
-		  DFS(adjId);
-		}		
-		else if (visitedCycle[adjId] == true) { //CYCLE
-		  //cout << "CYCLE" << endl;
-		}
+	GLuint id = stack[top - 1];
+	GLuint j = mpvoState[id] >> MPVO_FACE_SHIFT; // resume at the face being traversed
+	bool descend = false;
+
+	// for each adjacent tet
+	for (; j < 4; j++) {
+	  GLuint adjId = volume.conTet[id][j];
+
+	  // boundary adjacency (index is current) or not predecessor
+	  if ((adjId == id) || !(mpvoState[id] & MPVO_DAG(j)))
+		continue;
+
+	  if (!(mpvoState[adjId] & MPVO_VISITED)) {
+		// keep the face and traverse the predecessor first
+		mpvoState[id] = (mpvoState[id] & ~(3 << MPVO_FACE_SHIFT)) | (j << MPVO_FACE_SHIFT);
+		mpvoState[adjId] = (mpvoState[adjId] & MPVO_DAG_MASK) | MPVO_VISITED | MPVO_ONSTACK;
+		stack[top++] = adjId;
+		descend = true;
+		break;
+	  }
+	  else if (mpvoState[adjId] & MPVO_ONSTACK) { //CYCLE
+		DFScycles++;
 	  }
 	}
+
+	if (descend)
+	  continue;
+
+	mpvoState[id] &= ~MPVO_ONSTACK;
+	top--;
+
+	// output cell
+	out[DFScount] = id;
+	DFScount++;
   }
-  visitedCycle[id] = false;
-  
-  // output cell
-  ids[DFScount] = id;
-  DFScount++;
- 
+
   return;
 }
 
 /// Direct Acyclic Graph
-GLuint haptVol::DAG( void ){
+GLuint haptVol::DAG( const GLfloat *mv ){
   // for each tet compute if arrow is coming or going to neighbor
   GLuint nT = volume.numTets;
 
   // View direction x inverted modelview (avoid rotating normals)
-  vcg::Matrix44f imv;
-  glGetv(GL_MODELVIEW_MATRIX, imv);
-  Invert(imv);
-  vcg::Point3f vd = imv * vcg::Point3f(0, 0, -1);
-  vec3 viewDir (vd[0], vd[1], vd[2]);
+  vec3 viewDir = viewDirection(mv);
 
-  // original modelview for centroid rotation
-  GLfloat mv[16];
-  glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+  // directions are recomputed, incremental bin states are lost
+  faceBins.invalidate();
 
   GLuint adjId = 0;
   vec3 normal;
   bool boundary;
   GLuint centroidId = 0;
-  vec4 centroidVert;
-  GLfloat centroidZ;
 
   // for each tet
   for (GLuint i = 0; i < nT; ++i) {
 
-	// resets vector while computing dag
-	visited[i] = false;
-	visitedCycle[i] = false;
+	// resets visited flags while computing dag (keep arrows set by neighbors)
+	mpvoState[i] &= MPVO_DAG_MASK;
 	boundary = false;
 
 	// for each adjacent tetrahedral, i.e., each face of current tet
@@ -482,17 +674,10 @@ GLuint haptVol::DAG( void ){
 		if ((normal ^ viewDir) >= 0.0) {			  
 		  boundary = true;
 
-		  // retrieve tetrahedron centroid
-		  centroidVert = vec4( centroidList[i].x(), centroidList[i].y(), centroidList[i].z(), 1.0 );
-
-		  /// Apply ModelView Matrix mv (z -> r=2)
-		  centroidZ = 0.0;
-		  for (GLuint c = 0; c < 4; ++c)
-			centroidZ += mv[2+c*4] * centroidVert[c];
-
 		  // insert centroid in list of boundary tets to be sorted
+		  // (apply ModelView Matrix mv, z -> r=2)
 		  centroidSorted[centroidId].id = i;
-		  centroidSorted[centroidId].cZ = centroidZ;
+		  centroidSorted[centroidId].cZ = centroids.depth(i, mv);
 		  centroidId ++;			
 		}		
 	  }
@@ -505,17 +690,17 @@ GLuint haptVol::DAG( void ){
 		// if normal and view_dir are pointing in same direction current tet occluded
 		if ((normal ^ viewDir) > 0.0) {
 		  // arrow out, current occluded by adjacent
-		  dag[i][j] = 0;
+		  mpvoState[i] &= ~MPVO_DAG(j);
 		  for (GLuint k = 0; k < 4; k++) { // search for current tet in adjacency list of neighbor
 			if (volume.conTet[adjId][k] == i)
-			  dag[adjId][k] = 1; // adjacent tet - arrow in
+			  mpvoState[adjId] |= MPVO_DAG(k); // adjacent tet - arrow in
 		  }
 		}
 		else {
-		  dag[i][j] = 1;
+		  mpvoState[i] |= MPVO_DAG(j);
 		  for (GLuint k = 0; k < 4; k++) { // search for current tet in adjacency list of neighbor
 			if (volume.conTet[adjId][k] == i) 
-			  dag[adjId][k] = 0; // adjacent tet - arrow out
+			  mpvoState[adjId] &= ~MPVO_DAG(k); // adjacent tet - arrow out
 		  }
 		} 
 	  }
@@ -528,211 +713,1645 @@ GLuint haptVol::DAG( void ){
 /// Meshed Polyhedra Visibility Ordering for Non-Convex Meshes
 /// The mpvo for non convex meshes runs exactly as the original mpvo but
 /// executes the DFS traversing the centroid ordering of the front facing boundary cells
-void haptVol::MPVO( void ) {
+void haptVol::MPVO( GLuint *out, const GLfloat *mv, bool incremental ) {
 
 	// Compute Direct Acyclic Graph direction (MPVO Phase II)
-	GLuint boundaryTets = DAG();
+	GLuint boundaryTets = ( incremental ) ? incrementalDAG( mv ) : DAG( mv );
 
-	/// STL centroid sort for boundary faces only
-	std::sort( centroidSorted, centroidSorted + boundaryTets, less<tetCentroid>() );
+	/// Parallel centroid sort for boundary faces only
+	cpuSorter.sampleSort( centroidSorted, boundaryTets );
 
-	// resets the global counter for the final ordering during DFS
+	// resets the global counters for the final ordering during DFS
 	DFScount = 0;
+	DFScycles = 0;
 
 	// Depth First Search (MPVO Phase III)
 	for (GLuint i = 0; i < boundaryTets; i++)
-		DFS(centroidSorted[i].id);
+		DFS(centroidSorted[i].id, out);
 
 }
 
-/// Sort
-void haptVol::sort(sortType _sT) {
-
-	if( _sT == none ) return;
+/// Parallel Direct Acyclic Graph
+GLuint haptVol::parallelDAG( const GLfloat *mv ){
 
 	GLuint nT = volume.numTets;
 
-	GLfloat mv[16];
+	vec3 viewDir = viewDirection(mv);
 
-	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+	faceBins.invalidate();
 
-	GLuint *cpuIds = ids; ///< ids in CPU
+	/// Each tet sets only its own four directions.  A shared face is
+	/// always decided by the normal of its lowest tet id (as in DAG),
+	/// so both sides agree even on edge-on faces
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i) {
 
-	if( useBufObj ) { // Get ids in GPU
+		GLuint successors = 0;
+		GLubyte state = 0;
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
-		ids = (GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+		for (GLuint j = 0; j < 4; ++j) {
+
+			GLuint adjId = volume.conTet[i][j];
+
+			if( adjId == (GLuint)i ) {
+
+				// front facing boundary face
+				if( (volume.faceNormals[i*4 + j] ^ viewDir) >= 0.0 ) state |= MPVO_VISITED;
+				continue;
+
+			}
+
+			bool arrowIn; ///< adjacent tet is drawn before current
+
+			if( adjId > (GLuint)i )
+				arrowIn = !( (volume.faceNormals[i*4 + j] ^ viewDir) > 0.0 );
+			else {
+				GLuint k = 0; // search for current tet in adjacency list of neighbor
+				while( k < 3 && volume.conTet[adjId][k] != (GLuint)i ) ++k;
+				arrowIn = ( (volume.faceNormals[adjId*4 + k] ^ viewDir) > 0.0 );
+			}
+
+			if( arrowIn ) state |= MPVO_DAG(j);
+			else ++successors;
+
+		}
+
+		mpvoCount[i] = successors;
+		mpvoState[i] = state; ///< visited is the front facing boundary flag, until compaction
 
 	}
 
-	/// Switch to the selected sort method
-	if( _sT == stl_sort) {
+	/// Compact the front facing boundary tets, keeping the id order
+	GLuint numBoundary = 0;
+	GLuint *offsets = mpvoOffsets;
 
-		vec4 centroidVert;
-		GLfloat centroidZ;
+#pragma omp parallel num_threads(mpvoThreads)
+	{
 
-		/// Fill the centroid sorted array using the centroid Z
-		for (GLuint i = 0; i < nT; ++i) {
+		GLuint t = omp_get_thread_num(), nt = omp_get_num_threads();
+		GLuint begin = (GLuint)( ( (unsigned long long)nT * t ) / nt );
+		GLuint end = (GLuint)( ( (unsigned long long)nT * (t + 1) ) / nt );
+		GLuint count = 0;
 
-			centroidVert = vec4( centroidList[i].x(), centroidList[i].y(),
-					     centroidList[i].z(), 1.0 );
+		for (GLuint i = begin; i < end; ++i)
+			if( mpvoState[i] & MPVO_VISITED ) ++count;
 
-			/// Apply ModelView Matrix mv (z -> r=2)
-			centroidZ = 0.0;
-			for (GLuint c = 0; c < 4; ++c)
-				centroidZ += mv[2+c*4] * centroidVert[c];
+		offsets[t + 1] = count;
 
-			centroidSorted[i].id = i;
-			centroidSorted[i].cZ = centroidZ;
+#pragma omp barrier
+#pragma omp single
+		{
+			offsets[0] = 0;
+			for (GLuint k = 0; k < nt; ++k) offsets[k + 1] += offsets[k];
+			numBoundary = offsets[nt];
 		}
 
-		/// STL sort
-		std::sort( centroidSorted, centroidSorted + nT, less<tetCentroid>() );
+		GLuint pos = offsets[t];
 
-		/// ids has ordered list of ids back-to-front
-		for(GLuint i = 0; i < nT; ++i)
-			ids[i] = centroidSorted[i].id;		  
+		for (GLuint i = begin; i < end; ++i) {
 
-	} else if(_sT == mpvo) {
+			if( !(mpvoState[i] & MPVO_VISITED) ) continue;
 
-		MPVO();
+			// (apply ModelView Matrix mv, z -> r=2)
+			centroidSorted[pos].id = i;
+			centroidSorted[pos].cZ = centroids.depth(i, mv);
+			++pos;
 
-	} else if( _sT == gpu_bitonic ) {
+			mpvoState[i] &= ~MPVO_VISITED;
 
-		bitonicSortCUDA( ids, mv[2], mv[6], mv[10] );
+		}
 
-	} else if( _sT == gpu_quick ) {
-		quickSortCUDA( ids, mv[2], mv[6], mv[10] );
 	}
 
-	if( useBufObj ) {
-		glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		ids = cpuIds;
-	}	
+	return numBoundary;
 
 }
 
-/// Draw
-void haptVol::draw() {
+/// Incremental Direct Acyclic Graph
+GLuint haptVol::incrementalDAG( const GLfloat *mv ){
 
-	glEnable(GL_BLEND);
+	GLuint nT = volume.numTets;
 
-	glEnableClientState(GL_VERTEX_ARRAY);
+	if( !faceBins.valid() ) { ///< first use: bin the faces and list the external ones
 
-	glDisable(GL_CULL_FACE);
+		if( !volume.extFaces ) volume.buildExtF();
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ARRAY_BUFFER, bufObject[0]);
-		glVertexPointer(4, GL_FLOAT, 0, 0);
-	} else
-		glVertexPointer(4, GL_FLOAT, 0, bufArray[0]);
+		faceBins.build( volume );
 
-	glClientActiveTexture(GL_TEXTURE0 + 0);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	}
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ARRAY_BUFFER, bufObject[1]);
-		glTexCoordPointer(4, GL_FLOAT, 0, 0);
-	} else
-		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[1]);
+	vec3 viewDir = viewDirection(mv);
+	viewDir.normalize();
 
-	glClientActiveTexture(GL_TEXTURE0 + 1);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	GLuint revisited = 0;
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ARRAY_BUFFER, bufObject[2]);
-		glTexCoordPointer(4, GL_FLOAT, 0, 0);
-	} else
-		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[2]);
+	/// Only bins not entirely on the same side as before are revisited
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:revisited)
+	for (GLint b = 0; b < (GLint)faceBins.size(); ++b) {
 
-	glClientActiveTexture(GL_TEXTURE0 + 2);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		GLint side = faceBins.side(b, viewDir);
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ARRAY_BUFFER, bufObject[3]);
-		glTexCoordPointer(4, GL_FLOAT, 0, 0);
-	} else
-		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[3]);
+		if( side != BIN_MIXED && side == faceBins.state(b) ) continue;
 
-	haptShader->use();
+		const GLuint *faces = faceBins.binFaces(b);
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
-		glDrawElements(GL_POINTS, volume.numTets, GL_UNSIGNED_INT, 0);
-	} else
-		glDrawElements(GL_POINTS, volume.numTets, GL_UNSIGNED_INT, ids);
+		for (GLuint f = 0; f < faceBins.binSize(b); ++f) {
 
-	haptShader->use(0);
+			GLuint i = faces[f] / 4, j = faces[f] % 4;
+			GLuint adjId = volume.conTet[i][j];
+
+			// if normal and view_dir are pointing in same direction current tet occluded
+			bool arrowOut = ( side == BIN_MIXED ) ? ( (volume.faceNormals[faces[f]] ^ viewDir) > 0.0 )
+				: ( side == BIN_POSITIVE );
+
+			GLuint k = 0; // search for current tet in adjacency list of neighbor
+			while( k < 3 && volume.conTet[adjId][k] != i ) ++k;
+
+			/// Tets have faces in other bins, updated by other threads
+			if( arrowOut ) {
+#pragma omp atomic
+				mpvoState[i] &= (GLubyte)~MPVO_DAG(j);
+#pragma omp atomic
+				mpvoState[adjId] |= (GLubyte)MPVO_DAG(k);
+			} else {
+#pragma omp atomic
+				mpvoState[i] |= (GLubyte)MPVO_DAG(j);
+#pragma omp atomic
+				mpvoState[adjId] &= (GLubyte)~MPVO_DAG(k);
+			}
+
+		}
+
+		revisited += faceBins.binSize(b);
+
+		faceBins.setState(b, side);
 
-	if( useBufObj ) {
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
-	glDisableClientState(GL_VERTEX_ARRAY);
+	dagRevisited = revisited;
 
-	glClientActiveTexture(GL_TEXTURE0 + 0);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	// resets visited flags
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i)
+		mpvoState[i] &= MPVO_DAG_MASK;
 
-	glClientActiveTexture(GL_TEXTURE0 + 1);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	/// Front facing boundary tets from the external faces (a tet
+	/// might have more than one, the visited bit marks it as inserted)
+	GLuint centroidId = 0;
 
-	glClientActiveTexture(GL_TEXTURE0 + 2);
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	for (GLuint e = 0; e < volume.numExtFaces; ++e) {
 
-	glDisable(GL_BLEND);
+		GLuint i = volume.extFaces[e][0], j = volume.extFaces[e][1];
+
+		if( (mpvoState[i] & MPVO_VISITED) || (volume.faceNormals[i*4 + j] ^ viewDir) < 0.0 ) continue;
+
+		mpvoState[i] |= MPVO_VISITED;
+
+		// (apply ModelView Matrix mv, z -> r=2)
+		centroidSorted[centroidId].id = i;
+		centroidSorted[centroidId].cZ = centroids.depth(i, mv);
+		centroidId ++;
+
+	}
+
+	for (GLuint c = 0; c < centroidId; ++c)
+		mpvoState[ centroidSorted[c].id ] &= MPVO_DAG_MASK;
+
+	return centroidId;
 
 }
 
-/// Refresh Transfer Function (TF) and Brightness
-void haptVol::refreshTFandBrightness(GLfloat brightness) {
+/// Parallel Meshed Polyhedra Visibility Ordering for Non-Convex Meshes
+void haptVol::parallelMPVO( GLuint *out, const GLfloat *mv ) {
 
-	GLfloat *tfTexBuffer;
-	tfTexBuffer = new GLfloat[256*4];
+	GLuint nT = volume.numTets;
 
-	for (GLuint i = 0; i < 256; ++i)
-		for (GLuint j = 0; j < 4; ++j)
-			tfTexBuffer[i*4 + j] = volume.tf[i][j];
+	// Compute Direct Acyclic Graph direction (MPVO Phase II)
+	GLuint boundaryTets = parallelDAG( mv );
 
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_1D, tfTex);
-	glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_FLOAT, tfTexBuffer);
+	/// Parallel centroid sort for boundary faces only
+	cpuSorter.sampleSort( centroidSorted, boundaryTets );
 
-	haptShader->use();
-	haptShader->set_uniform("tfTex", 5);
-	haptShader->use(0);
+	/// First level: sorted front facing boundary tets with no successors,
+	/// i.e. drawn last (nearest last, as in the DFS roots order)
+	GLuint levelBegin = 0, levelEnd = 0;
+
+	for (GLuint i = 0; i < boundaryTets; ++i) {
+
+		GLuint id = centroidSorted[i].id;
+
+		if( mpvoCount[id] == 0 ) {
+			mpvoState[id] |= MPVO_VISITED;
+			mpvoQueue[levelEnd++] = id;
+		}
+
+	}
+
+	GLuint *offsets = mpvoOffsets;
+
+	// Topological sort (MPVO Phase III), one level per step
+#pragma omp parallel num_threads(mpvoThreads)
+	{
+
+		GLuint t = omp_get_thread_num(), nt = omp_get_num_threads();
+		GLuint *next = mpvoNext + t * ( 4 * (size_t)( (nT + nt - 1) / nt ) + 4 ); ///< Thread next level tets
+
+		while( levelBegin < levelEnd ) {
+
+			GLuint size = levelEnd - levelBegin;
+			GLuint begin = levelBegin + (GLuint)( ( (unsigned long long)size * t ) / nt );
+			GLuint end = levelBegin + (GLuint)( ( (unsigned long long)size * (t + 1) ) / nt );
+			GLuint count = 0;
+
+			for (GLuint q = begin; q < end; ++q) {
+
+				GLuint id = mpvoQueue[q];
+
+				// output level back-to-front: the queue is front-to-back
+				out[ nT - levelEnd + (q - levelBegin) ] = id;
+
+				// release the predecessors (incoming arrows)
+				for (GLuint j = 0; j < 4; ++j) {
+
+					GLuint adjId = volume.conTet[id][j];
+
+					if( adjId == id || !(mpvoState[id] & MPVO_DAG(j)) ) continue;
+
+					GLuint left;
+#pragma omp atomic capture
+					left = --mpvoCount[adjId];
+
+					if( left == 0 ) next[count++] = adjId;
+
+				}
+
+			}
+
+			offsets[t + 1] = count;
+
+#pragma omp barrier
+#pragma omp single
+			{
+				offsets[0] = levelEnd;
+				for (GLuint k = 0; k < nt; ++k) offsets[k + 1] += offsets[k];
+			}
+
+			for (GLuint k = 0; k < count; ++k) {
+				mpvoState[ next[k] ] |= MPVO_VISITED;
+				mpvoQueue[ offsets[t] + k ] = next[k];
+			}
+
+#pragma omp barrier
+#pragma omp single
+			{
+				levelBegin = levelEnd;
+				levelEnd = offsets[nt];
+			}
+
+		}
+
+	}
+
+	/// Tets left in cycles (never released) are drawn first
+	GLuint cycleTets = 0;
+
+	for (GLuint i = 0; i < nT; ++i) {
+
+		if( mpvoState[i] & MPVO_VISITED ) mpvoState[i] &= ~MPVO_VISITED;
+		else out[cycleTets++] = i;
 
-	if (drawMode != isos) {
-	  haptShader->use();
-	  haptShader->set_uniform("brightness", brightness);
-	  haptShader->use(0);
 	}
-	delete [] tfTexBuffer;
 
 }
 
-/// Refresh Iso-Surface
-void haptVol::refreshISO( void ) {
+/// Order Cache
+bool haptVol::loadOrderCache( void ) {
+
+	orderCacheTried = true;
+
+	string fnOrd = volName + ordExt;
+
+	clock_t ctBegin = clock();
+
+	if( viewOrders.read( fnOrd.c_str(), volume.numTets ) ) {
+
+		if (debug) cout << "Reading view-direction order cache : "
+				<< ( clock() - ctBegin ) / (double)CLOCKS_PER_SEC << " s" << endl;
+
+		return true;
+
+	}
+
+	if (debug) cout << "Building and writing view-direction order cache : " << flush;
+
+	if( !viewOrders.build( centroids, cpuSorter ) ) {
+		cerr << "Not enough memory for the view-direction order cache" << endl;
+		return false;
+	}
+
+	if( !viewOrders.write( fnOrd.c_str() ) )
+		cerr << "Could not write " << fnOrd << endl;
+
+	if (debug) cout << ( clock() - ctBegin ) / (double)CLOCKS_PER_SEC << " s" << endl;
+
+	return true;
 
-  if (drawMode != dvr) {	
-	haptShader->use();
-	haptShader->set_uniform("isoValue", volume.iso[0][0], volume.iso[1][0], volume.iso[2][0], volume.iso[3][0] );
-	haptShader->set_uniform("isoOpacity", volume.iso[0][1], volume.iso[1][1], volume.iso[2][1], volume.iso[3][1] );
-	haptShader->set_uniform("illumination", volume.iso[6][0], volume.iso[4][0], volume.iso[5][0]);
-	haptShader->set_uniform("illuminate", (GLint)useLight);
-	haptShader->use(0);
-  }
 }
 
-/// Create Shaders
-bool haptVol::switchShaders( drawType _dt ) {
+/// Centroid Sort Error
+void haptVol::computeCentroidSortError( sortType _sT ) {
 
-  if( haptShader ) delete haptShader;
-  haptShader = new glslKernel();
-  if( !haptShader ) return false;
+	/// Sort-first orders live in the tile lists, not in the ids
+	if( sortFirst ) { sortErrorArea[_sT] = sortErrorFaces[_sT] = -1.0; return; }
 
-  drawMode = _dt;
+	if( !volume.conTet || !volume.faceNormals ) return;
+
+	GLfloat mv[16];
+
+	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+
+	const GLuint *order = ids; ///< Current ordering
+
+	if( useBufObj ) { // Read ids from GPU
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
+		order = (const GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY);
+
+	}
+
+	computeSortError( _sT, mv, order, drawCount );
+
+	if( useBufObj ) {
+		glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+}
+
+/// Compute the sort error of an ordering
+void haptVol::computeSortError( sortType _sT, const GLfloat *mv, const GLuint *order, GLuint n ) {
+
+	GLuint nT = volume.numTets;
+
+	/// The rank array is sort scratch, used by the worker while pipelined
+	if( pipelined ) { sortErrorArea[_sT] = sortErrorFaces[_sT] = -1.0; return; }
+
+	if( !volume.conTet || !volume.faceNormals ) return;
+
+	vec3 viewDir = viewDirection(mv);
+
+	/// Position of each tet in the ordering (depth keys are free after
+	/// sorting), nT for the tets not drawn (culled or inactive)
+	GLuint *rank = ( depthKeys ) ? depthKeys : (GLuint*)packedIds;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i)
+		rank[i] = nT;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)n; ++i)
+		rank[ order[i] ] = i;
+
+	double invArea = 0.0, totArea = 0.0;
+	long long invFaces = 0, totFaces = 0;
+
+	/// Each interior face is checked once, from the lowest tet id
+#pragma omp parallel for reduction(+:invArea,totArea,invFaces,totFaces)
+	for (GLint i = 0; i < (GLint)nT; ++i) {
+
+		for (GLuint j = 0; j < 4; ++j) {
+
+			GLuint adjId = volume.conTet[i][j];
+
+			if( adjId <= (GLuint)i ) continue; ///< boundary or already checked
+
+			if( rank[i] == nT || rank[adjId] == nT ) continue; ///< not both drawn
+
+			GLfloat facing = volume.faceNormals[i*4 + j] ^ viewDir;
+
+			if( facing == 0.0 ) continue; ///< edge-on face, any order is right
+
+			/// Shared face area
+			vec3 v0 = volume.vertList[ volume.tetList[i][ MOD4(0, j) ] ].xyz();
+			vec3 v1 = volume.vertList[ volume.tetList[i][ MOD4(1, j) ] ].xyz();
+			vec3 v2 = volume.vertList[ volume.tetList[i][ MOD4(2, j) ] ].xyz();
+			double area = 0.5 * ((v1 - v0) % (v2 - v0)).length();
+
+			totArea += area;
+			++totFaces;
+
+			/// Normal pointing into tet i along the view: i is behind and must
+			/// come first (last when compositing front-to-back)
+			bool iFirst = ( frontToBack ) ? rank[i] > rank[adjId] : rank[i] < rank[adjId];
+
+			if( (facing > 0.0) != iFirst ) {
+				invArea += area;
+				++invFaces;
+			}
+
+		}
+
+	}
+
+	sortErrorArea[_sT] = ( totArea > 0.0 ) ? invArea / totArea : 0.0;
+	sortErrorFaces[_sT] = ( totFaces > 0 ) ? invFaces / (GLfloat)totFaces : 0.0;
+
+}
+
+/// View unchanged
+bool haptVol::viewUnchanged(sortType _sT, const GLfloat *mv) const {
+
+	if( !lastViewValid || _sT != lastViewSort ) return false;
+
+	/// The translation moves the eye point used by the DAG sorts (and
+	/// the perspective rays), so it has to be the same
+	if( mv[12] != lastView[3] || mv[13] != lastView[4] || mv[14] != lastView[5] ) return false;
+
+	/// Otherwise the order depends only on the depth row direction
+	if( mv[2] == lastView[0] && mv[6] == lastView[1] && mv[10] == lastView[2] ) return true;
+
+	if( viewTolerance <= 0.0 ) return false;
+
+	GLfloat dot = mv[2] * lastView[0] + mv[6] * lastView[1] + mv[10] * lastView[2];
+	GLfloat len = sqrt( (mv[2] * mv[2] + mv[6] * mv[6] + mv[10] * mv[10])
+			    * (lastView[0] * lastView[0] + lastView[1] * lastView[1] + lastView[2] * lastView[2]) );
+
+	return ( len > 0.0 ) && ( dot >= len * cos( viewTolerance * M_PI / 180.0 ) );
+
+}
+
+/// Create Sort Arrays
+bool haptVol::createSortArrays(bool hostIds) {
+
+	GLuint nT = volume.numTets;
+
+	drawCount = nT;
+
+	if( hostIds ) {
+		ids = new GLuint[nT];
+		if( !ids ) return false;
+	}
+
+	if( compactMode ) return createSorters(); ///< No MPVO
+
+	mpvoState = new GLubyte[nT];
+	if( !mpvoState ) return false;
+	memset(mpvoState, 0, nT * sizeof(GLubyte));
+
+	mpvoCount = new GLuint[nT];
+	if( !mpvoCount ) return false;
+
+	mpvoQueue = new GLuint[nT];
+	if( !mpvoQueue ) return false;
+
+	/// Parallel MPVO thread offsets and next level tets (a thread
+	/// releases at most four tets per tet of its part of a level)
+	mpvoThreads = omp_get_max_threads();
+
+	mpvoOffsets = new GLuint[mpvoThreads + 1];
+	if( !mpvoOffsets ) return false;
+
+	mpvoNext = new GLuint[4 * (size_t)nT + 8 * mpvoThreads];
+	if( !mpvoNext ) return false;
+
+	/// Sorter registry (built-in sort methods and plug-ins), once
+	/// all their data exists
+	return createSorters();
+
+}
+
+/// Sort-only Setup
+bool haptVol::sortSetup() {
+
+	try {
+
+		if( debug ) cout << "Create centroid sortings... " << flush;
+
+		if( !createCentroidSorts() ) throw errHandle(memoryErr);
+
+		if( debug ) cout << "done!\nCreate sort arrays... " << flush;
+
+		if( !createSortArrays() ) throw errHandle(memoryErr);
+
+		if( debug ) cout << "done!" << endl;
+
+		return true;
+
+	} catch(errHandle& e) {
+
+		cerr << e;
+
+		return false;
+
+	}
+
+}
+
+/// Sort for a modelview
+void haptVol::sort(sortType _sT, const GLfloat *mv) {
+
+	if( _sT == none ) return;
+
+	memcpy( sortMV, mv, 16 * sizeof(GLfloat) );
+
+	if( frustumActive() ) cullToFrustum();
+
+	drawCount = sortIds(_sT, ids, sortMV);
+
+}
+
+/// Sort
+void haptVol::sort(sortType _sT) {
+
+	sortSkipped = false;
+
+	if( _sT == none ) return;
+
+	glGetFloatv(GL_MODELVIEW_MATRIX, sortMV);
+	glGetFloatv(GL_PROJECTION_MATRIX, sortProj);
+
+	if( sortFirst ) { sortTiles(); return; }
+
+	if( frustumActive() ) { ///< A new frustum (zoom or pan) changes the tets in view
+
+		GLfloat mvp[16];
+
+		sortMVP( mvp );
+
+		if( frustum.changed( mvp ) ) invalidateSortCache();
+
+	}
+
+	/// Reuse the last order (kept in ids or in the element buffer)
+	if( viewUnchanged(_sT, sortMV) ) {
+		sortSkipped = true;
+		return;
+	}
+
+	lastViewValid = true;
+	lastViewSort = _sT;
+	lastView[0] = sortMV[2]; lastView[1] = sortMV[6]; lastView[2] = sortMV[10];
+	lastView[3] = sortMV[12]; lastView[4] = sortMV[13]; lastView[5] = sortMV[14];
+
+	if( frustumActive() ) cullToFrustum();
+
+	if( useBufObj && activeSubset() && ids ) { ///< Filtered and remapped in CPU (the write-only mapping is not read back)
+
+		drawCount = sortIds(_sT, ids, sortMV);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, drawCount * sizeof(GLuint), ids);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		return;
+
+	}
+
+	GLuint *cpuIds = ids; ///< ids in CPU
+
+	if( useBufObj ) { // Get ids in GPU
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
+		ids = (GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+
+	}
+
+	drawCount = sortIds(_sT, ids, sortMV);
+
+	if( useBufObj ) {
+		glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		ids = cpuIds;
+	}	
+
+}
+
+/// OpenGL extension check
+///   True if the extension is in the extension string or the context
+///   version (major.minor) has it in core
+static bool glExtension(const char *name, GLint major, GLint minor) {
+
+	GLint ctxMajor = 0, ctxMinor = 0;
+	const char *version = (const char*)glGetString(GL_VERSION);
+
+	if( version && sscanf( version, "%d.%d", &ctxMajor, &ctxMinor ) == 2 &&
+	    ( ctxMajor > major || ( ctxMajor == major && ctxMinor >= minor ) ) ) return true;
+
+	const char *ext = (const char*)glGetString(GL_EXTENSIONS);
+
+	if( !ext ) return false;
+
+	size_t len = strlen(name);
+
+	for (const char *p = strstr(ext, name); p; p = strstr(p + len, name))
+		if( ( p == ext || p[-1] == ' ' ) && ( p[len] == ' ' || p[len] == '\0' ) ) return true;
+
+	return false;
+
+}
+
+/// Pipelined sort
+void haptVol::pipelineSort(GLdouble& _t, sortType _sT) {
+
+	static struct timeval starttime, endtime;
+	gettimeofday(&starttime, 0);
+
+	sortSkipped = false;
+
+	GLfloat mv[16];
+
+	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+
+	/// Ask the worker for the latest view only if it changed
+	if( pipelineSorts(_sT) && !viewUnchanged(_sT, mv) ) {
+
+		lastViewValid = true;
+		lastViewSort = _sT;
+		lastView[0] = mv[2]; lastView[1] = mv[6]; lastView[2] = mv[10];
+		lastView[3] = mv[12]; lastView[4] = mv[13]; lastView[5] = mv[14];
+
+		prepareSort( _sT ); ///< The worker builds nothing
+
+		GLfloat smv[16];
+
+		sortView( smv, mv ); ///< The worker does not read frontToBack
+
+		pipeline.request( _sT, smv );
+
+	} else sortSkipped = pipelineSorts(_sT);
+
+	/// Upload the newest completed order to the next element buffer
+	const GLuint *order = pipeline.acquire();
+
+	if( order ) {
+
+		GLint next = (pipeDraw + 1) % NUM_SORT_SLOTS;
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pipeBufObject[next]);
+
+		if( syncObjects ) { ///< Wait until the GPU is done drawing from this buffer
+			if( pipeFence[next] ) {
+				glClientWaitSync( (GLsync)pipeFence[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 );
+				glDeleteSync( (GLsync)pipeFence[next] );
+				pipeFence[next] = NULL;
+			}
+		} else ///< Orphan the buffer, so the driver does not wait for the GPU
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, volume.numTets * sizeof(GLuint), 0, GL_STREAM_DRAW);
+
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, volume.numTets * sizeof(GLuint), order);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		pipeline.release();
+
+		pipeDraw = next;
+
+	}
+
+	gettimeofday(&endtime, 0);
+	_t = (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
+
+}
+
+/// Pipeline worker sort
+void haptVol::pipelineSortIds(void *obj, GLint method, const GLfloat *mv, GLuint *order) {
+
+	/// Only the sorter: no subset while pipelined, and ids and sortMV
+	/// belong to the OpenGL thread
+	((haptVol*)obj)->runSorter( (sortType)method, order, mv );
+
+}
+
+/// Set pipelined mode
+bool haptVol::usePipeline(bool _p) {
+
+	if( _p == pipelined ) return true;
+
+	if( _p && ( sortFirst || cullEmpty ) ) return false; ///< Tile lists and visible lists change the order size
+
+	if( _p ) {
+
+		pipelined = true; ///< Before the worker reads it
+
+		if( !pipeline.start( volume.numTets, pipelineSortIds, this ) ) { pipelined = false; return false; }
+
+		syncObjects = glExtension("GL_ARB_sync", 3, 2);
+
+		glGenBuffers(NUM_SORT_SLOTS, pipeBufObject);
+
+		for (GLuint k = 0; k < NUM_SORT_SLOTS; ++k) {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pipeBufObject[k]);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, volume.numTets * sizeof(GLuint), 0, GL_STREAM_DRAW);
+			pipeFence[k] = NULL;
+		}
+
+		/// The tets in id order are drawn until the first completed
+		/// order (and with no sort method)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pipeBufObject[0]);
+
+		GLuint *order = (GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+
+		if( order ) {
+#pragma omp parallel for
+			for (GLint i = 0; i < (GLint)volume.numTets; ++i)
+				order[i] = i;
+			glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		}
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		pipeDraw = ( order ) ? 0 : -1;
+
+	} else {
+
+		pipeline.stop();
+
+		/// The worker is done: drop a completed order not yet uploaded
+		if( pipeline.acquire() ) pipeline.release();
+
+		for (GLuint k = 0; k < NUM_SORT_SLOTS; ++k) {
+			if( pipeFence[k] ) glDeleteSync( (GLsync)pipeFence[k] );
+			pipeFence[k] = NULL;
+		}
+
+		glDeleteBuffers(NUM_SORT_SLOTS, pipeBufObject);
+
+		for (GLuint k = 0; k < NUM_SORT_SLOTS; ++k) pipeBufObject[k] = 0;
+
+		pipelined = false; ///< After the worker stopped
+
+	}
+
+	drawCount = volume.numTets; ///< Pipelined orders have all tets
+
+	invalidateSortCache();
+
+	return true;
+
+}
+
+/// Set sort-first mode
+bool haptVol::useSortFirst(bool _s) {
+
+	if( _s && ( compactMode || pipelined || !depthKeys ) ) return false;
+
+	sortFirst = _s;
+
+	invalidateSortCache();
+
+	return true;
+
+}
+
+/// Set empty-tet culling
+bool haptVol::useEmptyCulling(bool _c) {
+
+	if( _c && ( compactMode || pipelined || !culling.valid() ) ) return false;
+
+	if( _c && !culling.update(volume) ) return false;
+
+	cullEmpty = _c;
+
+	invalidateSortCache();
+
+	return true;
+
+}
+
+/// Set front-to-back compositing
+bool haptVol::useFrontToBack(bool _f) {
+
+	if( _f ) { ///< Accumulated opacity and termination mask
+
+		GLint alphaBits = 0, stencilBits = 0;
+
+		glGetIntegerv(GL_ALPHA_BITS, &alphaBits);
+		glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+
+		if( alphaBits == 0 || stencilBits == 0 ) return false;
+
+	}
+
+	frontToBack = _f;
+
+	setColor( backGround.r(), backGround.g(), backGround.b() );
+
+	invalidateSortCache();
+
+	return true;
+
+}
+
+/// Built-in sort method
+///   Runs a haptVol sort method on the given ids and modelview, the
+///   volume ids and sortMV are left untouched
+class haptVol::builtinSorter : public visibilitySorter {
+
+public:
+
+	typedef void (haptVol::*sortMethod)( GLuint *out, const GLfloat *mv );
+
+	builtinSorter(haptVol *_v, sortType _t, sortMethod _m, const char *_name, char _key) :
+		visibilitySorter(_name, _key), vol(_v), type(_t), method(_m) { }
+
+	/// Sort data is built by haptVol, check the one of the method
+	bool init(const offVol< GLfloat, GLuint >&, const centroidStore& c) {
+
+		GLuint nT = vol->volume.numTets;
+
+		switch( type ) {
+		case cpu_compact: return !vol->compactMode || vol->packedIds; ///< Built on first use otherwise
+		case gpu_bitonic: case gpu_quick: return vol->cudaReady;
+		case kd_tree: return c.size() == nT; ///< Built on first use
+		default: break;
+		}
+
+		if( !vol->centroidSorted || !vol->depthKeys || !vol->prevOrder || c.size() != nT ) return false;
+
+		switch( type ) {
+		case mpvo: case mpvo_incremental: return vol->mpvoState && vol->mpvoQueue;
+		case mpvo_parallel: return vol->mpvoState && vol->mpvoCount && vol->mpvoQueue && vol->mpvoOffsets && vol->mpvoNext;
+		default: return true;
+		}
+
+	}
+
+	void sort(GLuint *out, const GLfloat *mv) { (vol->*method)( out, mv ); }
+
+	/// Sort data used by the method (shared data is reported by every
+	/// method using it, haptVol::sizeOf counts it once)
+	size_t sizeOf(void) { return vol->sortMethodSizeOf( type ); }
+
+private:
+
+	haptVol *vol; ///< Volume sorted
+
+	sortType type; ///< Sort method id
+
+	sortMethod method; ///< Sort method
+
+};
+
+/// Create sorters
+bool haptVol::createSorters(void) {
+
+	sorters.clear();
+
+	if( compactMode ) { ///< Only the sort data of the compact sort exists
+
+		sorters.add( new builtinSorter( this, cpu_compact, &haptVol::sortCompact, "CPU Compact (packed keys)", 'z' ), cpu_compact );
+
+		return sorters.init( volume, centroids ) > 0;
+
+	}
+
+	sorters.add( new builtinSorter( this, stl_sort, &haptVol::sortSTL, "STL Sort", '1' ), stl_sort );
+	if( cudaReady ) { ///< Not without a CUDA device
+#ifdef NO_CUDA
+		sorters.add( new builtinSorter( this, gpu_bitonic, &haptVol::sortBitonic, "CPU Bitonic (no CUDA)", '2' ), gpu_bitonic );
+		sorters.add( new builtinSorter( this, gpu_quick, &haptVol::sortQuick, "CPU Quicksort (no CUDA)", '3' ), gpu_quick );
+#else
+		sorters.add( new builtinSorter( this, gpu_bitonic, &haptVol::sortBitonic, "GPU Bitonic", '2' ), gpu_bitonic );
+		sorters.add( new builtinSorter( this, gpu_quick, &haptVol::sortQuick, "GPU Quicksort", '3' ), gpu_quick );
+#endif
+	}
+	sorters.add( new builtinSorter( this, mpvo, &haptVol::sortMPVO, "MPVO", '4' ), mpvo );
+	sorters.add( new builtinSorter( this, cpu_radix, &haptVol::sortRadix, "CPU Radix", '5' ), cpu_radix );
+	sorters.add( new builtinSorter( this, cpu_incremental, &haptVol::sortIncremental, "CPU Incremental", '6' ), cpu_incremental );
+	sorters.add( new builtinSorter( this, cpu_bucket, &haptVol::sortBucket, "CPU Approximate (buckets)", 'a' ), cpu_bucket );
+	sorters.add( new builtinSorter( this, mpvo_parallel, &haptVol::parallelMPVO, "MPVO (parallel)", 'm' ), mpvo_parallel );
+	sorters.add( new builtinSorter( this, cpu_cached, &haptVol::sortCached, "CPU Cached Directions", 'c' ), cpu_cached );
+	sorters.add( new builtinSorter( this, mpvo_incremental, &haptVol::sortMPVOIncremental, "MPVO (incremental DAG)", 'n' ), mpvo_incremental );
+	sorters.add( new builtinSorter( this, kd_tree, &haptVol::sortKdTree, "k-d Tree Traversal", 'k' ), kd_tree );
+	sorters.add( new builtinSorter( this, brick_sort, &haptVol::sortBricks, "Bricks (two-level)", 'g' ), brick_sort );
+	sorters.add( new builtinSorter( this, cpu_compact, &haptVol::sortCompact, "CPU Compact (packed keys)", 'z' ), cpu_compact );
+
+	GLuint numPlugins = sorters.addPlugins();
+
+	if( sorters.init( volume, centroids ) == 0 ) return false;
+
+	if( debug && numPlugins ) cout << numPlugins << " plug-in sorter(s) registered" << endl;
+
+	return true;
+
+}
+
+/// Sort ids
+GLuint haptVol::sortIds(sortType _sT, GLuint *out, const GLfloat *mv) {
+
+	GLfloat smv[16];
+
+	sortView( smv, mv );
+
+	if( !runSorter( _sT, out, smv ) ) return drawCount;
+
+	tetSubset *subset = activeSubset();
+
+	if( !subset ) return volume.numTets;
+
+	/// STL and radix sorts sorted only the subset list
+	if( _sT == stl_sort || _sT == cpu_radix ) return subset->size();
+
+	return subset->filter( out, volume.numTets );
+
+}
+
+/// Run sorter
+bool haptVol::runSorter(sortType _sT, GLuint *out, const GLfloat *mv) {
+
+	visibilitySorter *s = sorters.get( _sT );
+
+	if( !s ) return false;
+
+	s->run( out, mv );
+
+	return true;
+
+}
+
+/// Sort view
+void haptVol::sortView(GLfloat *smv, const GLfloat *mv) const {
+
+	memcpy( smv, mv, 16 * sizeof(GLfloat) );
+
+	if( frontToBack ) { ///< Reversed depth row: the same sorts output front-to-back
+		smv[2] = -smv[2]; smv[6] = -smv[6]; smv[10] = -smv[10]; smv[14] = -smv[14];
+	}
+
+}
+
+/// Prepare sort
+void haptVol::prepareSort(sortType _sT) {
+
+	if( _sT == kd_tree && !spatialTree.valid() ) { ///< Preprocessing on first use
+
+		if (debug) cout << "Building k-d tree : " << flush;
+		clock_t ctBegin = clock();
+
+		if( !spatialTree.build( centroids ) ) cerr << "Not enough memory for the k-d tree" << endl;
+
+		if (debug) cout << ( clock() - ctBegin ) / (double)CLOCKS_PER_SEC << " s" << endl;
+
+	} else if( _sT == brick_sort && !bricks.valid() ) { ///< Preprocessing on first use
+
+		if (debug) cout << "Building bricks : " << flush;
+		clock_t ctBegin = clock();
+
+		if( !bricks.build( centroids ) ) cerr << "Not enough memory for the bricks" << endl;
+
+		if (debug) cout << ( clock() - ctBegin ) / (double)CLOCKS_PER_SEC << " s" << endl;
+
+	} else if( _sT == cpu_compact && !packedIds ) { ///< Built on first use outside of the compact mode
+
+		if( !qCentroids.build(volume) ) return;
+		packedIds = new uint_64[volume.numTets];
+
+	} else if( _sT == cpu_cached && !orderCacheTried )
+		loadOrderCache();
+
+}
+
+/// STL sort
+void haptVol::sortSTL( GLuint *out, const GLfloat *mv ) {
+
+	GLuint nT = volume.numTets;
+
+	const tetSubset *subset = activeSubset();
+
+	if( subset ) { ///< Only the visible tets or active cells
+
+		nT = subset->size();
+
+		const GLuint *visible = subset->list();
+
+#pragma omp parallel for
+		for (GLint i = 0; i < (GLint)nT; ++i) {
+			centroidSorted[i].id = visible[i];
+			centroidSorted[i].cZ = centroids.depth( visible[i], mv );
+		}
+
+	} else {
+
+		/// Fill the centroid sorted array using the centroid Z
+#pragma omp parallel for
+		for (GLint i = 0; i < (GLint)nT; ++i)
+			centroidSorted[i].id = i;
+
+		/// Apply ModelView Matrix mv (z -> r=2)
+		centroids.depths( &centroidSorted[0].cZ, mv, sizeof(tetCentroid) / sizeof(GLfloat) );
+
+	}
+
+	/// Parallel sample sort (std::sort order)
+	cpuSorter.sampleSort( centroidSorted, nT );
+
+	/// out has ordered list of ids back-to-front
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i)
+		out[i] = centroidSorted[i].id;
+
+}
+
+/// Radix sort
+void haptVol::sortRadix( GLuint *out, const GLfloat *mv ) {
+
+	GLuint nT = volume.numTets;
+
+	const tetSubset *subset = activeSubset();
+
+	if( subset ) { ///< Only the visible tets or active cells (keys gathered from the list)
+
+		nT = subset->size();
+
+		const GLuint *visible = subset->list();
+
+		centroids.keys( depthKeys, visible, nT, mv );
+
+		cpuSorter.radixSort( out, depthKeys, nT );
+
+		/// Key indices to tet ids
+#pragma omp parallel for
+		for (GLint i = 0; i < (GLint)nT; ++i)
+			out[i] = visible[ out[i] ];
+
+		return;
+
+	}
+
+	/// Fill the keys with the monotone centroid Z (z -> r=2)
+	centroids.keys( depthKeys, mv );
+
+	/// Parallel radix sort writes ids back-to-front
+	cpuSorter.radixSort( out, depthKeys, nT );
+
+}
+
+/// Modelview-projection of the sort
+void haptVol::sortMVP(GLfloat *mvp) const {
+
+	for (GLuint c = 0; c < 4; ++c)
+		for (GLuint r = 0; r < 4; ++r)
+			mvp[c*4 + r] = sortProj[r] * sortMV[c*4] + sortProj[4 + r] * sortMV[c*4 + 1]
+				+ sortProj[8 + r] * sortMV[c*4 + 2] + sortProj[12 + r] * sortMV[c*4 + 3];
+
+}
+
+/// View-frustum culling
+void haptVol::cullToFrustum( void ) {
+
+	GLfloat mvp[16];
+
+	sortMVP( mvp );
+
+	/// Only among the visible tets or active cells
+	const GLubyte *mask = NULL;
+
+	if( isoIndexActive() ) mask = isoIndex.subset().flags();
+	else if( cullActive() ) mask = culling.subset().flags();
+
+	frustum.update( volume, mvp, mask );
+
+}
+
+/// Sort-first sort
+void haptVol::sortTiles( void ) {
+
+	GLfloat mvp[16];
+	GLint viewport[4];
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	sortMVP( mvp );
+
+	if( frustumActive() ) cullToFrustum();
+
+	/// Centroid Z keys (z -> r=2, reversed front-to-back), sorted only inside each tile
+	GLfloat smv[16];
+
+	sortView( smv, sortMV );
+
+	centroids.keys( depthKeys, smv );
+
+	const tetSubset *subset = activeSubset();
+
+	if( !tiles.sort( volume, depthKeys, mvp, viewport, (subset) ? subset->flags() : NULL ) ) {
+		cerr << "Sort-first: out of memory for the tile lists" << endl;
+		return;
+	}
+
+	if( useBufObj ) { ///< Tile lists change size every frame
+
+		if( !tileBufObject ) glGenBuffers(1, &tileBufObject);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileBufObject);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, tiles.size() * sizeof(GLuint), tiles.order(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	}
+
+}
+
+/// Repair sort
+void haptVol::repairSort( GLuint *out, const GLfloat *mv, bool cached ) {
+
+	GLuint nT = volume.numTets;
+
+	lastRepaired = false;
+
+	if( cached && ( orderCacheTried || loadOrderCache() ) && viewOrders.valid() ) {
+
+		/// Start from the order of the nearest cached direction
+		lastCachedDir = viewOrders.nearestOrder( prevOrder, viewDirection(mv) );
+
+		prevOrderValid = true;
+
+	}
+
+	if( prevOrderValid ) {
+
+		/// Recompute the keys following the previous frame order
+		centroids.keys( depthKeys, prevOrder, nT, mv );
+
+		/// Repair the order, if it did not change too much
+		lastRepaired = cpuSorter.adaptiveSort( prevOrder, depthKeys, nT, maxDisorder );
+
+	}
+
+	if( !lastRepaired ) { ///< Full sort from scratch
+
+		centroids.keys( depthKeys, mv );
+
+		cpuSorter.radixSort( prevOrder, depthKeys, nT );
+
+		prevOrderValid = true;
+
+	}
+
+	/// Keep the order for the next frame and output it
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i)
+		out[i] = prevOrder[i];
+
+}
+
+/// Incremental sort
+void haptVol::sortIncremental( GLuint *out, const GLfloat *mv ) {
+
+	repairSort( out, mv, false );
+
+}
+
+/// Cached directions sort
+void haptVol::sortCached( GLuint *out, const GLfloat *mv ) {
+
+	repairSort( out, mv, true );
+
+}
+
+/// Bucket sort
+void haptVol::sortBucket( GLuint *out, const GLfloat *mv ) {
+
+	GLuint nT = volume.numTets;
+
+	/// Fill the keys with the monotone centroid Z (z -> r=2)
+	centroids.keys( depthKeys, mv );
+
+	/// Single counting sort pass over 2^bucketBits depth buckets
+	cpuSorter.bucketSort( out, depthKeys, nT, bucketBits, &bucketWidth, &bucketInversions );
+
+}
+
+/// Bricks sort
+void haptVol::sortBricks( GLuint *out, const GLfloat *mv ) {
+
+	prepareSort( brick_sort );
+
+	/// Bricks by depth, then tets inside each brick in parallel
+	if( bricks.valid() ) bricks.sort( out, centroidSorted, centroids, mv );
+
+}
+
+/// k-d tree sort
+void haptVol::sortKdTree( GLuint *out, const GLfloat *mv ) {
+
+	prepareSort( kd_tree );
+
+	/// Back-to-front traversal, leaves sorted in parallel
+	if( spatialTree.valid() ) spatialTree.sort( out, centroids, mv );
+
+}
+
+/// Bitonic sort
+void haptVol::sortBitonic( GLuint *out, const GLfloat *mv ) {
+
+	bitonicSortCUDA( out, mv[2], mv[6], mv[10] );
+
+}
+
+/// Quick sort
+void haptVol::sortQuick( GLuint *out, const GLfloat *mv ) {
+
+	quickSortCUDA( out, mv[2], mv[6], mv[10] );
+
+}
+
+/// Compact sort
+void haptVol::sortCompact( GLuint *out, const GLfloat *mv ) {
+
+	GLuint nT = volume.numTets;
+
+	prepareSort( cpu_compact );
+
+	if( !packedIds ) return;
+
+	/// Packed keys (depth, id) from the quantized centroids (z -> r=2)
+	qCentroids.packedKeys( packedIds, mv );
+
+	/// In-place sort of the packed keys
+	cpuSorter.packedSort( packedIds, nT );
+
+	/// Ids (low words) back-to-front, straight to the mapped buffer
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nT; ++i)
+		out[i] = (GLuint)packedIds[i];
+
+}
+
+
+/// Draw
+void haptVol::draw() {
+
+	glEnable(GL_BLEND);
+
+	GLint view[4];
+
+	glGetIntegerv(GL_VIEWPORT, view);
+
+	if( frontToBack ) { ///< Under operator, terminated pixels masked in the stencil
+
+		glBlendFunc(GL_ONE_MINUS_DST_ALPHA, GL_ONE);
+
+		glClearStencil(0);
+		glClear(GL_STENCIL_BUFFER_BIT);
+
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_EQUAL, 0, 1);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+	glDisable(GL_CULL_FACE);
+
+	if( useBufObj ) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufObject[0]);
+		glVertexPointer(4, GL_FLOAT, 0, 0);
+	} else
+		glVertexPointer(4, GL_FLOAT, 0, bufArray[0]);
+
+	glClientActiveTexture(GL_TEXTURE0 + 0);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if( useBufObj ) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufObject[1]);
+		glTexCoordPointer(4, GL_FLOAT, 0, 0);
+	} else
+		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[1]);
+
+	glClientActiveTexture(GL_TEXTURE0 + 1);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if( useBufObj ) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufObject[2]);
+		glTexCoordPointer(4, GL_FLOAT, 0, 0);
+	} else
+		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[2]);
+
+	glClientActiveTexture(GL_TEXTURE0 + 2);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if( useBufObj ) {
+		glBindBuffer(GL_ARRAY_BUFFER, bufObject[3]);
+		glTexCoordPointer(4, GL_FLOAT, 0, 0);
+	} else
+		glTexCoordPointer(4, GL_FLOAT, 0, bufArray[3]);
+
+	haptShader->use();
+
+	if( pipelined ) { ///< Last completed order (id order before the first one)
+		if( pipeDraw >= 0 ) {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pipeBufObject[pipeDraw]);
+			drawOrder(NULL, 0, volume.numTets, view);
+			if( syncObjects ) {
+				if( pipeFence[pipeDraw] ) glDeleteSync( (GLsync)pipeFence[pipeDraw] );
+				pipeFence[pipeDraw] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
+	} else if( sortFirst )
+		drawTiles();
+	else if( useBufObj ) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufObject[4]);
+		drawOrder(NULL, 0, drawCount, view);
+	} else
+		drawOrder(ids, 0, drawCount, view);
+
+	haptShader->use(0);
+
+	if( useBufObj ) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glClientActiveTexture(GL_TEXTURE0 + 0);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	glClientActiveTexture(GL_TEXTURE0 + 1);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	glClientActiveTexture(GL_TEXTURE0 + 2);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if( frontToBack ) {
+
+		glDisable(GL_STENCIL_TEST);
+
+		drawBackground();
+
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	}
+
+	glDisable(GL_BLEND);
+
+}
+
+/// Draw order
+void haptVol::drawOrder( const GLuint *order, GLuint first, GLuint count, const GLint *rect ) {
+
+	GLuint batch = count, end = first + count;
+
+	if( frontToBack ) {
+		batch = (count + TERMINATION_PASSES - 1) / TERMINATION_PASSES;
+		if( batch < TERMINATION_BATCH ) batch = TERMINATION_BATCH;
+	}
+
+	for (GLuint b = first; b < end; b += batch) {
+
+		GLuint n = (end - b < batch) ? end - b : batch;
+
+		if( order ) glDrawElements(GL_POINTS, n, GL_UNSIGNED_INT, order + b);
+		else glDrawElements(GL_POINTS, n, GL_UNSIGNED_INT, (const GLvoid*)( b * sizeof(GLuint) ));
+
+		if( b + n < end ) terminationPass( rect );
+
+	}
+
+}
+
+/// Early termination pass
+void haptVol::terminationPass( const GLint *rect ) {
+
+	haptShader->use(0);
+
+	/// Copied pixels pass the alpha test only if opaque enough
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, terminationOpacity);
+
+	glStencilFunc(GL_ALWAYS, 1, 1);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+	glWindowPos2i( rect[0], rect[1] );
+	glCopyPixels( rect[0], rect[1], rect[2], rect[3], GL_COLOR );
+
+	glStencilFunc(GL_EQUAL, 0, 1);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+	glDisable(GL_ALPHA_TEST);
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	haptShader->use();
+
+}
+
+/// Draw background
+void haptVol::drawBackground( void ) {
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	/// Opaque background under the accumulated color
+	glColor4f(backGround.r(), backGround.g(), backGround.b(), 1.0);
+	glRectf(-1.0, -1.0, 1.0, 1.0);
+
+	glPopMatrix();
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+
+	glMatrixMode(GL_MODELVIEW);
+
+	glPopAttrib();
+
+}
+
+/// Sort-first draw
+void haptVol::drawTiles() {
+
+	if( tiles.size() == 0 ) return;
+
+	if( useBufObj ) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, tileBufObject);
+
+	glEnable(GL_SCISSOR_TEST);
+
+	GLint rect[4];
+	GLsizei w, h;
+
+	/// Tiles do not overlap: each one is composited alone
+	for (GLuint t = 0; t < tiles.numTiles(); ++t) {
+
+		if( tiles.tileCount(t) == 0 ) continue;
+
+		tiles.tileRect(t, rect[0], rect[1], w, h);
+		rect[2] = w; rect[3] = h;
+
+		glScissor(rect[0], rect[1], rect[2], rect[3]);
+
+		drawOrder( (useBufObj) ? NULL : tiles.order(), tiles.tileFirst(t), tiles.tileCount(t), rect );
+
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+
+}
+
+/// Software Draw
+void haptVol::softwareDraw() {
+
+	GLint vp[4];
+	GLfloat mv[16], proj[16], mvp[16];
+
+	glGetIntegerv(GL_VIEWPORT, vp);
+	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+	glGetFloatv(GL_PROJECTION_MATRIX, proj);
+
+	for (GLuint c = 0; c < 4; ++c)
+		for (GLuint r = 0; r < 4; ++r)
+			mvp[c*4 + r] = proj[r] * mv[c*4] + proj[4 + r] * mv[c*4 + 1]
+				+ proj[8 + r] * mv[c*4 + 2] + proj[12 + r] * mv[c*4 + 3];
+
+	/// Current order (the element buffer drawn by draw)
+	GLuint orderBuf = 0;
+
+	if( pipelined ) {
+		if( pipeDraw < 0 ) return; ///< No order uploaded
+		orderBuf = pipeBufObject[pipeDraw];
+	} else if( useBufObj )
+		orderBuf = bufObject[4];
+
+	const GLuint *order = ids;
+
+	if( orderBuf ) { // Read ids from GPU
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, orderBuf);
+		order = (const GLuint*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY);
+
+	}
+
+	bool drawn = softwareDraw( vp[2], vp[3], mvp, order );
+
+	if( orderBuf ) {
+		glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+	if( !drawn ) return;
+
+	/// Image already composited over the background
+	glWindowPos2i( vp[0], vp[1] );
+	glDrawPixels( softRenderer.width(), softRenderer.height(), GL_RGBA, GL_FLOAT, softRenderer.image() );
+
+}
+
+/// Software Draw without a window
+bool haptVol::softwareDraw(GLuint w, GLuint h, const GLfloat *mvp, const GLuint *order, GLuint n) {
+
+	if( !order && pipelined ) return false; ///< ids are not sorted while pipelined
+
+	if( !order ) order = ids;
+
+	if( n == 0 ) n = drawCount;
+
+	if( !order ) return false;
+
+	/// Renderer data on first use
+	if( !softRenderer.init( &psiGammaTable[0][0], PSI_GAMMA_SIZE_BACK, PSI_GAMMA_SIZE_FRONT ) ) return false;
+
+	if( !softRenderer.resize( w, h ) ) return false;
+
+	softRenderer.setBrightness( softBrightness );
+
+	softRenderer.clear( backGround.r(), backGround.g(), backGround.b() );
+
+	softRenderer.render( volume, order, n, mvp );
+
+	return true;
+
+}
+
+/// Refresh Transfer Function (TF) and Brightness
+void haptVol::refreshTFandBrightness(GLfloat brightness) {
+
+	GLfloat *tfTexBuffer;
+	tfTexBuffer = new GLfloat[256*4];
+
+	for (GLuint i = 0; i < 256; ++i)
+		for (GLuint j = 0; j < 4; ++j)
+			tfTexBuffer[i*4 + j] = volume.tf[i][j];
+
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_1D, tfTex);
+	glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_FLOAT, tfTexBuffer);
+
+	haptShader->use();
+	haptShader->set_uniform("tfTex", 5);
+	haptShader->use(0);
+
+	if (drawMode != isos) {
+	  haptShader->use();
+	  haptShader->set_uniform("brightness", brightness);
+	  haptShader->use(0);
+	  softBrightness = brightness;
+	}
+	delete [] tfTexBuffer;
+
+	/// Visible list of the new transfer function
+	if( cullEmpty ) {
+		culling.update(volume);
+		invalidateSortCache();
+	}
+
+}
+
+/// Refresh Iso-Surface
+void haptVol::refreshISO( void ) {
+
+  if (drawMode != dvr) {	
+	haptShader->use();
+	haptShader->set_uniform("isoValue", volume.iso[0][0], volume.iso[1][0], volume.iso[2][0], volume.iso[3][0] );
+	haptShader->set_uniform("isoOpacity", volume.iso[0][1], volume.iso[1][1], volume.iso[2][1], volume.iso[3][1] );
+	haptShader->set_uniform("illumination", volume.iso[6][0], volume.iso[4][0], volume.iso[5][0]);
+	haptShader->set_uniform("illuminate", (GLint)useLight);
+	haptShader->use(0);
+  }
+
+  /// Active cells of the new iso-values
+  if( isoIndex.valid() ) {
+	activeIsoCells();
+	invalidateSortCache();
+  }
+}
+
+/// Active Iso-Surface Cells
+void haptVol::activeIsoCells( void ) {
+
+	/// Iso-surfaces drawn by hapt_iso.geom (non-zero value and opacity)
+	GLfloat values[4];
+	GLuint n = 0;
+
+	for (GLuint i = 0; volume.iso && i < 4; ++i)
+		if( volume.iso[i][0] != 0.0 && volume.iso[i][1] != 0.0 )
+			values[n++] = volume.iso[i][0];
+
+	isoIndex.query( values, n );
+
+}
+
+/// Create Shaders
+bool haptVol::switchShaders( drawType _dt ) {
+
+  if( haptShader ) delete haptShader;
+  haptShader = new glslKernel();
+  if( !haptShader ) return false;
+
+  drawMode = _dt;
+
+  invalidateSortCache(); ///< Empty-tet culling only in DVR, active cells only in isos
 
   GLint max_geom_output = 8;
 
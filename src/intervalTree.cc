@@ -0,0 +1,262 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   intervalTree : defines a class to index the tetrahedra scalar ranges
+ *                  in an interval tree and to list the active cells, i.e.
+ *                  the tetrahedra crossed by the iso-surfaces.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "intervalTree.h"
+
+#include <algorithm>
+
+/// Compare tets by the midpoint of their scalar range
+struct midLess {
+	const GLfloat *lo, *hi;
+	midLess(const GLfloat *_l, const GLfloat *_h) : lo(_l), hi(_h) { }
+	bool operator () (GLuint a, GLuint b) const { return lo[a] + hi[a] < lo[b] + hi[b]; }
+};
+
+/// Compare tets by one scalar bound (ascending or descending)
+struct boundLess {
+	const GLfloat *bound; bool descending;
+	boundLess(const GLfloat *_b, bool _d) : bound(_b), descending(_d) { }
+	bool operator () (GLuint a, GLuint b) const { return (descending) ? bound[a] > bound[b] : bound[a] < bound[b]; }
+};
+
+/// Scalar range entirely below a value
+struct rangeBelow {
+	const GLfloat *hi; GLfloat v;
+	rangeBelow(const GLfloat *_h, GLfloat _v) : hi(_h), v(_v) { }
+	bool operator () (GLuint t) const { return hi[t] < v; }
+};
+
+/// Scalar range not entirely above a value
+struct rangeNotAbove {
+	const GLfloat *lo; GLfloat v;
+	rangeNotAbove(const GLfloat *_l, GLfloat _v) : lo(_l), v(_v) { }
+	bool operator () (GLuint t) const { return lo[t] <= v; }
+};
+
+/// ----------------------------------   intervalTree   ------------------------------------
+
+/// Constructor
+intervalTree::intervalTree() :
+	numTets(0),
+	nodes(NULL), nodeCount(0),
+	byMin(NULL), minValue(NULL),
+	byMax(NULL), maxValue(NULL) {
+
+}
+
+/// Destructor
+intervalTree::~intervalTree() {
+
+	if( nodes ) delete [] nodes;
+	if( byMin ) delete [] byMin;
+	if( minValue ) delete [] minValue;
+	if( byMax ) delete [] byMax;
+	if( maxValue ) delete [] maxValue;
+
+}
+
+/// Build tree
+bool intervalTree::build(const offVol< GLfloat, GLuint >& vol) {
+
+	numTets = vol.numTets;
+	nodeCount = 0;
+
+	if( nodes ) delete [] nodes;
+	nodes = NULL;
+
+	if( !numTets ) return false;
+
+	if( byMin ) delete [] byMin;
+	byMin = new GLuint[ numTets ];
+	if( !byMin ) return false;
+
+	if( minValue ) delete [] minValue;
+	minValue = new GLfloat[ numTets ];
+	if( !minValue ) return false;
+
+	if( byMax ) delete [] byMax;
+	byMax = new GLuint[ numTets ];
+	if( !byMax ) return false;
+
+	if( maxValue ) delete [] maxValue;
+	maxValue = new GLfloat[ numTets ];
+	if( !maxValue ) return false;
+
+	if( !active.create( numTets ) ) return false;
+
+	/// Scalar range of each tet (kept in minValue and maxValue until
+	/// they are rewritten in the node lists order)
+	GLfloat *lo = minValue, *hi = maxValue;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numTets; ++i) {
+
+		lo[i] = hi[i] = vol.vertList[ vol.tetList[i][0] ][3];
+
+		for (GLuint j = 1; j < 4; ++j) {
+			GLfloat s = vol.vertList[ vol.tetList[i][j] ][3];
+			if( s < lo[i] ) lo[i] = s;
+			if( s > hi[i] ) hi[i] = s;
+		}
+
+		byMin[i] = i;
+
+	}
+
+	/// At most one node per tet (every node keeps at least its median tet)
+	intervalNode *tree = new intervalNode[ numTets ];
+	if( !tree ) return false;
+
+	GLfloat *nodeMin = new GLfloat[ numTets ], *nodeMax = new GLfloat[ numTets ];
+	if( !nodeMin || !nodeMax ) return false;
+
+	/// Split the nodes depth-first (stack of tet range and parent link);
+	/// the children of a node have at most half of its tets
+	struct { GLuint begin, end; GLint *link; } stack[128];
+	GLint top = 0;
+
+	stack[top].begin = 0; stack[top].end = numTets; stack[top].link = NULL;
+
+	while( top >= 0 ) {
+
+		GLuint begin = stack[top].begin, end = stack[top].end;
+		GLint *link = stack[top].link;
+		--top;
+
+		GLuint *first = byMin + begin, *last = byMin + end, *median = first + (end - begin) / 2;
+
+		std::nth_element( first, median, last, midLess(lo, hi) );
+
+		GLfloat center = ( lo[*median] + hi[*median] ) / 2.0;
+
+		/// Ranges below the center, containing it and above it
+		GLuint *mid = std::partition( first, last, rangeBelow(hi, center) );
+		GLuint *above = std::partition( mid, last, rangeNotAbove(lo, center) );
+
+		GLuint m0 = mid - byMin, m1 = above - byMin;
+
+		intervalNode& node = tree[ nodeCount ];
+
+		node.center = center;
+		node.first = m0; node.count = m1 - m0;
+		node.left = node.right = -1;
+
+		if( link ) *link = nodeCount;
+		++nodeCount;
+
+		/// Node lists by ascending minimum and descending maximum
+		std::copy( mid, above, byMax + m0 );
+		std::sort( mid, above, boundLess(lo, false) );
+		std::sort( byMax + m0, byMax + m1, boundLess(hi, true) );
+
+		for (GLuint k = m0; k < m1; ++k) {
+			nodeMin[k] = lo[ byMin[k] ];
+			nodeMax[k] = hi[ byMax[k] ];
+		}
+
+		if( m1 < end ) {
+			++top;
+			stack[top].begin = m1; stack[top].end = end; stack[top].link = &node.right;
+		}
+
+		if( begin < m0 ) {
+			++top;
+			stack[top].begin = begin; stack[top].end = m0; stack[top].link = &node.left;
+		}
+
+	}
+
+	delete [] minValue;
+	delete [] maxValue;
+
+	minValue = nodeMin;
+	maxValue = nodeMax;
+
+	/// Keep only the nodes used
+	nodes = new intervalNode[ nodeCount ];
+	if( !nodes ) return false;
+
+	std::copy( tree, tree + nodeCount, nodes );
+
+	delete [] tree;
+
+	return true;
+
+}
+
+/// Active cells
+void intervalTree::query(const GLfloat *values, GLuint n) {
+
+	if( !nodes ) return;
+
+	/// Clear the flags of the last query (only the active tets)
+	active.clear();
+
+	for (GLuint v = 0; v < n; ++v) {
+
+		GLfloat q = values[v];
+
+		GLint i = 0;
+
+		while( i >= 0 ) {
+
+			const intervalNode& node = nodes[i];
+
+			GLuint k = node.first, last = node.first + node.count;
+
+			if( q < node.center ) { ///< Node ranges starting at or below q
+
+				for ( ; k < last && minValue[k] <= q; ++k)
+					active.add( byMin[k] );
+
+				i = node.left;
+
+			} else if( q > node.center ) { ///< Node ranges ending at or above q
+
+				for ( ; k < last && maxValue[k] >= q; ++k)
+					active.add( byMax[k] );
+
+				i = node.right;
+
+			} else { ///< All node ranges contain q, children do not
+
+				for ( ; k < last; ++k)
+					active.add( byMin[k] );
+
+				i = -1;
+
+			}
+
+		}
+
+	}
+
+	/// Ascending ids, as the full order
+	std::sort( active.list(), active.list() + active.size() );
+
+}
+
+/// Size of interval tree
+size_t intervalTree::sizeOf(void) {
+
+	return ( ( (nodes) ? nodeCount * sizeof(intervalNode) : 0 ) + ///< Tree nodes
+		 ( (byMin) ? (size_t)2 * numTets * ( sizeof(GLuint) + sizeof(GLfloat) ) : 0 ) + ///< Node lists
+		 ( active.sizeOf() ) + ///< Active tets
+		 ( 2 * sizeof(GLuint) ) + ///< All GLuints
+		 ( 5 * sizeof(void*) ) ///< All pointers
+		);
+
+}
@@ -0,0 +1,161 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   kdTree : defines a class to build a k-d tree (axis-aligned BSP) over
+ *            the tetrahedra centroids and to order the tetrahedra by a
+ *            back-to-front traversal of the tree.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "kdTree.h"
+
+#include <algorithm>
+
+/// ----------------------------------   kdTree   ------------------------------------
+
+/// Constructor
+kdTree::kdTree() :
+	numTets(0), numLevels(0), numLeaves(0),
+	perm(NULL), axis(NULL),
+	leafBegin(NULL), leafEnd(NULL), leafOut(NULL) {
+
+}
+
+/// Destructor
+kdTree::~kdTree() {
+
+	if( perm ) delete [] perm;
+	if( axis ) delete [] axis;
+	if( leafBegin ) delete [] leafBegin;
+	if( leafEnd ) delete [] leafEnd;
+	if( leafOut ) delete [] leafOut;
+
+}
+
+/// Build tree
+bool kdTree::build(const centroidStore& c) {
+
+	numTets = c.size();
+
+	/// Levels until every leaf has at most KD_LEAF_SIZE tets
+	numLevels = c.splitLevels( KD_LEAF_SIZE );
+
+	numLeaves = 1 << numLevels;
+
+	if( perm ) delete [] perm;
+	perm = new GLuint[ numTets ];
+	if( !perm ) return false;
+
+	if( axis ) delete [] axis;
+	axis = new GLubyte[ numLeaves ]; ///< numLeaves - 1 internal nodes
+	if( !axis ) return false;
+
+	if( leafBegin ) delete [] leafBegin;
+	leafBegin = new GLuint[ numLeaves ];
+	if( !leafBegin ) return false;
+
+	if( leafEnd ) delete [] leafEnd;
+	leafEnd = new GLuint[ numLeaves ];
+	if( !leafEnd ) return false;
+
+	if( leafOut ) delete [] leafOut;
+	leafOut = new GLuint[ numLeaves ];
+	if( !leafOut ) return false;
+
+	/// Balanced split of the centroids, keeping the split axes
+	c.medianSplit( perm, numLevels, axis );
+
+	return true;
+
+}
+
+/// Size of k-d tree
+size_t kdTree::sizeOf(void) {
+
+	return ( ( (perm) ? numTets * sizeof(GLuint) : 0 ) + ///< Tets in tree order
+		 ( (axis) ? numLeaves * sizeof(GLubyte) : 0 ) + ///< Split axes
+		 ( (leafBegin) ? 3 * numLeaves * sizeof(GLuint) : 0 ) + ///< Leaves traversal
+		 ( 3 * sizeof(GLuint) ) + ///< numTets, numLevels, numLeaves
+		 ( 5 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Back-to-front order
+void kdTree::sort(GLuint *ids, const centroidStore& c, const GLfloat *mv) {
+
+	/// View direction (looking into the screen): farther centroids have
+	/// larger coordinates along the axes where it is positive
+	GLfloat viewDir[3] = { -mv[2], -mv[6], -mv[10] };
+
+	/// Traverse the tree far child first (stack of node, level and range)
+	struct { GLuint node, level, begin, end; } stack[64];
+	GLint top = 0;
+	GLuint leaf = 0, out = 0;
+
+	stack[top].node = 0; stack[top].level = 0;
+	stack[top].begin = 0; stack[top].end = numTets;
+	++top;
+
+	while( top > 0 ) {
+
+		--top;
+		GLuint node = stack[top].node, level = stack[top].level;
+		GLuint begin = stack[top].begin, end = stack[top].end;
+
+		if( level == numLevels ) { ///< leaf
+
+			leafBegin[leaf] = begin;
+			leafEnd[leaf] = end;
+			leafOut[leaf] = out;
+			out += end - begin;
+			++leaf;
+			continue;
+
+		}
+
+		GLuint mid = begin + (end - begin) / 2;
+		bool upperFar = ( viewDir[ axis[node] ] > 0.0 );
+
+		/// Push the near child first, so the far child is visited first
+		stack[top].node = 2 * node + ( upperFar ? 1 : 2 );
+		stack[top].level = level + 1;
+		stack[top].begin = upperFar ? begin : mid;
+		stack[top].end = upperFar ? mid : end;
+		++top;
+
+		stack[top].node = 2 * node + ( upperFar ? 2 : 1 );
+		stack[top].level = level + 1;
+		stack[top].begin = upperFar ? mid : begin;
+		stack[top].end = upperFar ? end : mid;
+		++top;
+
+	}
+
+	/// Sort each leaf by centroid Z into its slice of ids
+#pragma omp parallel for schedule(dynamic, 16)
+	for (GLint l = 0; l < (GLint)numLeaves; ++l) {
+
+		tetCentroid leafCentroids[ KD_LEAF_SIZE ];
+		GLuint size = leafEnd[l] - leafBegin[l];
+
+		for (GLuint i = 0; i < size; ++i) {
+			leafCentroids[i].id = perm[ leafBegin[l] + i ];
+			leafCentroids[i].cZ = c.depth( leafCentroids[i].id, mv );
+		}
+
+		std::sort( leafCentroids, leafCentroids + size );
+
+		for (GLuint i = 0; i < size; ++i)
+			ids[ leafOut[l] + i ] = leafCentroids[i].id;
+
+	}
+
+}
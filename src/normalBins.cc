@@ -0,0 +1,178 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   normalBins : defines a class to group the interior faces of the
+ *                volume by normal direction (cube map bins on the sphere),
+ *                used to update the MPVO DAG only where it can change.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "normalBins.h"
+
+#include <cmath>
+#include <cstring>
+
+/// Margin added to the bin cone sine to absorb rounding errors
+#define BIN_MARGIN 1e-5
+
+/// ----------------------------------   normalBins   ------------------------------------
+
+/// Cube map bin of a unit normal
+static GLuint cubeBin(const appVol::vec3& n, GLuint res) {
+
+	GLuint axis = 0;
+
+	if( fabs(n[1]) > fabs(n[axis]) ) axis = 1;
+	if( fabs(n[2]) > fabs(n[axis]) ) axis = 2;
+
+	GLuint face = axis * 2 + ( (n[axis] < 0.0) ? 1 : 0 );
+
+	GLfloat a = fabs(n[axis]);
+	GLfloat u = n[ (axis + 1) % 3 ] / a, v = n[ (axis + 2) % 3 ] / a;
+
+	GLint iu = (GLint)( (u + 1.0) * 0.5 * res ), iv = (GLint)( (v + 1.0) * 0.5 * res );
+
+	if( iu < 0 ) iu = 0;
+	if( iu >= (GLint)res ) iu = res - 1;
+	if( iv < 0 ) iv = 0;
+	if( iv >= (GLint)res ) iv = res - 1;
+
+	return ( face * res + iu ) * res + iv;
+
+}
+
+/// Constructor
+normalBins::normalBins() :
+	numBins(0),
+	binStart(NULL), faces(NULL),
+	binCenter(NULL), binSinRadius(NULL), binState(NULL) {
+
+}
+
+/// Destructor
+normalBins::~normalBins() {
+
+	if( binStart ) delete [] binStart;
+	if( faces ) delete [] faces;
+	if( binCenter ) delete [] binCenter;
+	if( binSinRadius ) delete [] binSinRadius;
+	if( binState ) delete [] binState;
+
+}
+
+/// Build bins
+bool normalBins::build(const offVol< GLfloat, GLuint >& vol, GLuint res) {
+
+	if( !vol.conTet || !vol.faceNormals ) return false;
+
+	numBins = 6 * res * res;
+
+	if( binStart ) delete [] binStart;
+	binStart = new GLuint[ numBins + 1 ];
+	if( !binStart ) return false;
+
+	if( binCenter ) delete [] binCenter;
+	binCenter = new GLfloat[ numBins * 3 ];
+	if( !binCenter ) return false;
+
+	if( binSinRadius ) delete [] binSinRadius;
+	binSinRadius = new GLfloat[ numBins ];
+	if( !binSinRadius ) return false;
+
+	if( binState ) delete [] binState;
+	binState = new signed char[ numBins ];
+	if( !binState ) return false;
+
+	memset( binStart, 0, (numBins + 1) * sizeof(GLuint) );
+	memset( binCenter, 0, numBins * 3 * sizeof(GLfloat) );
+
+	/// Count the faces and sum the normals of each bin
+	for (GLuint i = 0; i < vol.numTets; ++i) {
+
+		for (GLuint j = 0; j < 4; ++j) {
+
+			if( vol.conTet[i][j] <= i ) continue; ///< boundary or already binned
+
+			const vec3& n = vol.faceNormals[i*4 + j];
+			GLuint b = cubeBin(n, res);
+
+			binStart[b + 1]++;
+			for (GLuint k = 0; k < 3; ++k) binCenter[b*3 + k] += n[k];
+
+		}
+
+	}
+
+	for (GLuint b = 0; b < numBins; ++b) binStart[b + 1] += binStart[b];
+
+	if( faces ) delete [] faces;
+	faces = new GLuint[ binStart[numBins] ];
+	if( !faces ) return false;
+
+	/// Fill the bins, keeping the tet order inside each bin
+	GLuint *fill = new GLuint[ numBins ];
+	if( !fill ) return false;
+
+	memcpy( fill, binStart, numBins * sizeof(GLuint) );
+
+	for (GLuint i = 0; i < vol.numTets; ++i)
+		for (GLuint j = 0; j < 4; ++j)
+			if( vol.conTet[i][j] > i )
+				faces[ fill[ cubeBin(vol.faceNormals[i*4 + j], res) ]++ ] = i*4 + j;
+
+	delete [] fill;
+
+	/// Bin cone: mean direction and widest normal around it
+	for (GLuint b = 0; b < numBins; ++b) {
+
+		vec3 c( binCenter[b*3], binCenter[b*3+1], binCenter[b*3+2] );
+		GLfloat len = c.length();
+
+		if( len > 0.0 ) c = c / len;
+
+		GLfloat minCos = 1.0;
+
+		for (GLuint f = binStart[b]; f < binStart[b + 1]; ++f) {
+			GLfloat cs = vol.faceNormals[ faces[f] ] ^ c;
+			if( cs < minCos ) minCos = cs;
+		}
+
+		for (GLuint k = 0; k < 3; ++k) binCenter[b*3 + k] = c[k];
+
+		/// Cones wider than a hemisphere are always mixed
+		binSinRadius[b] = ( minCos > 0.0 ) ? sqrt( 1.0 - minCos * minCos ) + BIN_MARGIN : 2.0;
+
+	}
+
+	invalidate();
+
+	return true;
+
+}
+
+/// Invalidate bin states
+void normalBins::invalidate(void) {
+
+	if( binState ) memset( binState, BIN_UNKNOWN, numBins * sizeof(signed char) );
+
+}
+
+/// Size of normal bins
+size_t normalBins::sizeOf(void) {
+
+	return ( ( (faces) ? numFaces() * sizeof(GLuint) : 0 ) + ///< Binned faces
+		 ( (binStart) ? (numBins + 1) * sizeof(GLuint) : 0 ) + ///< Bin offsets
+		 ( (binCenter) ? numBins * 4 * sizeof(GLfloat) : 0 ) + ///< Bin cones
+		 ( (binState) ? numBins * sizeof(signed char) : 0 ) + ///< Bin states
+		 ( sizeof(GLuint) ) + ///< numBins
+		 ( 5 * sizeof(void*) ) ///< All pointers
+		);
+
+}
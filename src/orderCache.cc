@@ -0,0 +1,307 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   orderCache : defines a class to precompute and store the back-to-front
+ *                centroid orders for a set of view directions (geodesic
+ *                sphere), used as starting orders to be repaired at runtime.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "orderCache.h"
+
+#include <cmath>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <cstring>
+
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+
+/// ----------------------------------   orderCache   ------------------------------------
+
+/// Constructor
+orderCache::orderCache() :
+	numTets(0), numDirs(0),
+	dirs(NULL), orders(NULL) {
+
+}
+
+/// Destructor
+orderCache::~orderCache() {
+
+	if( dirs ) delete [] dirs;
+	if( orders ) delete [] orders;
+
+}
+
+/// Build orders
+bool orderCache::build(const centroidStore& c, cpuSort& sorter, GLuint level) {
+
+	/// Icosahedron
+	const GLfloat p = (1.0 + sqrt(5.0)) / 2.0;
+
+	std::vector< vec3 > verts;
+	verts.push_back( vec3(-1,  p,  0) ); verts.push_back( vec3( 1,  p,  0) );
+	verts.push_back( vec3(-1, -p,  0) ); verts.push_back( vec3( 1, -p,  0) );
+	verts.push_back( vec3( 0, -1,  p) ); verts.push_back( vec3( 0,  1,  p) );
+	verts.push_back( vec3( 0, -1, -p) ); verts.push_back( vec3( 0,  1, -p) );
+	verts.push_back( vec3( p,  0, -1) ); verts.push_back( vec3( p,  0,  1) );
+	verts.push_back( vec3(-p,  0, -1) ); verts.push_back( vec3(-p,  0,  1) );
+
+	static const GLuint icoFaces[20][3] = {
+		{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+		{1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+		{3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+		{4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1} };
+
+	std::vector< GLuint > faces( &icoFaces[0][0], &icoFaces[0][0] + 60 );
+
+	/// Geodesic sphere: split each triangle in four at the edge midpoints
+	for (GLuint l = 0; l < level; ++l) {
+
+		std::map< std::pair< GLuint, GLuint >, GLuint > midpoints;
+		std::vector< GLuint > subFaces;
+
+		for (GLuint f = 0; f < faces.size(); f += 3) {
+
+			GLuint m[3];
+
+			for (GLuint e = 0; e < 3; ++e) {
+
+				GLuint a = faces[f + e], b = faces[f + (e + 1) % 3];
+				std::pair< GLuint, GLuint > key( (a < b) ? a : b, (a < b) ? b : a );
+
+				if( midpoints.find(key) == midpoints.end() ) {
+					midpoints[key] = verts.size();
+					verts.push_back( (verts[a] + verts[b]) / 2.0 );
+				}
+
+				m[e] = midpoints[key];
+
+			}
+
+			GLuint sub[12] = { faces[f], m[0], m[2],  m[0], faces[f+1], m[1],
+					   m[2], m[1], faces[f+2],  m[0], m[1], m[2] };
+
+			subFaces.insert( subFaces.end(), sub, sub + 12 );
+
+		}
+
+		faces.swap( subFaces );
+
+	}
+
+	/// Keep one direction of each opposite pair (the sphere is symmetric)
+	std::vector< vec3 > half;
+
+	for (GLuint i = 0; i < verts.size(); ++i) {
+
+		vec3 d = verts[i] / verts[i].length();
+		const GLfloat eps = 1e-6;
+
+		if( d.z() > eps || ( fabs(d.z()) <= eps && ( d.y() > eps || ( fabs(d.y()) <= eps && d.x() > 0.0 ) ) ) )
+			half.push_back( d );
+
+	}
+
+	numTets = c.size();
+	numDirs = half.size();
+
+	if( dirs ) delete [] dirs;
+	dirs = new GLfloat[ numDirs * 3 ];
+	if( !dirs ) return false;
+
+	if( orders ) delete [] orders;
+	orders = new GLuint[ (size_t)numDirs * numTets ];
+	if( !orders ) return false;
+
+	GLuint *keys = new GLuint[ numTets ];
+	if( !keys ) return false;
+
+	for (GLuint d = 0; d < numDirs; ++d) {
+
+		for (GLuint k = 0; k < 3; ++k) dirs[d*3 + k] = half[d][k];
+
+		/// Eye-space z when looking along d (row 2 is minus the view direction)
+		GLfloat mv[16] = { 0.0 };
+		mv[2] = -half[d][0]; mv[6] = -half[d][1]; mv[10] = -half[d][2];
+
+		c.keys( keys, mv );
+
+		sorter.radixSort( orders + (size_t)d * numTets, keys, numTets );
+
+	}
+
+	delete [] keys;
+
+	return true;
+
+}
+
+/// Read orders
+bool orderCache::read(const char* f, GLuint _numTets) {
+
+	clear();
+
+	ifstream in(f, ios::in | ios::binary);
+
+	if (in.fail()) return false;
+
+	GLuint header[3]; ///< numTets, numDirs, level
+
+	in.read( (char*)header, sizeof(header) );
+
+	/// Same volume and directions as build, nothing else in the file
+	if (in.fail() || header[0] != _numTets || header[2] != ORDER_CACHE_LEVEL
+	    || header[1] != numDirections(ORDER_CACHE_LEVEL)) return false;
+
+	size_t dirsSize = (size_t)header[1] * 3 * sizeof(GLfloat);
+	size_t ordersSize = (size_t)header[1] * header[0] * sizeof(GLuint);
+
+	in.seekg( 0, ios::end );
+
+	if (in.fail() || (size_t)in.tellg() != sizeof(header) + dirsSize + ordersSize) return false;
+
+	in.seekg( sizeof(header), ios::beg );
+
+	numTets = header[0];
+	numDirs = header[1];
+
+	dirs = new GLfloat[ numDirs * 3 ];
+	orders = new GLuint[ (size_t)numDirs * numTets ];
+
+	if( !dirs || !orders ) { clear(); return false; }
+
+	in.read( (char*)dirs, dirsSize );
+	in.read( (char*)orders, ordersSize );
+
+	if (in.fail() || !validOrders()) { clear(); return false; }
+
+	in.close();
+
+	return true;
+
+}
+
+/// Check orders
+bool orderCache::validOrders(void) const {
+
+	/// Unit directions (nearestOrder divides by their length)
+	for (GLuint d = 0; d < numDirs; ++d) {
+
+		GLfloat len = sqrt( dirs[d*3] * dirs[d*3] + dirs[d*3+1] * dirs[d*3+1] + dirs[d*3+2] * dirs[d*3+2] );
+
+		if( !( fabs(len - 1.0) < 1e-3 ) ) return false;
+
+	}
+
+	/// Each order is a permutation of the tets (the gathers of the
+	/// repair sort index the centroids with them)
+	GLuint *seen = new GLuint[ numTets ]; ///< Last direction (plus one) listing each tet
+	if( !seen ) return false;
+
+	memset( seen, 0, numTets * sizeof(GLuint) );
+
+	bool valid = true;
+
+	for (GLuint d = 0; d < numDirs && valid; ++d) {
+
+		const GLuint *order = orders + (size_t)d * numTets;
+
+		for (GLuint i = 0; i < numTets && valid; ++i) {
+
+			if( order[i] >= numTets || seen[ order[i] ] == d + 1 ) valid = false;
+			else seen[ order[i] ] = d + 1;
+
+		}
+
+	}
+
+	delete [] seen;
+
+	return valid;
+
+}
+
+/// Clear orders
+void orderCache::clear(void) {
+
+	if( dirs ) delete [] dirs;
+	if( orders ) delete [] orders;
+
+	dirs = NULL;
+	orders = NULL;
+
+	numTets = numDirs = 0;
+
+}
+
+/// Write orders
+bool orderCache::write(const char* f) const {
+
+	if( !orders ) return false;
+
+	ofstream out(f, ios::out | ios::binary);
+
+	if (out.fail()) return false;
+
+	GLuint header[3] = { numTets, numDirs, ORDER_CACHE_LEVEL };
+
+	out.write( (const char*)header, sizeof(header) );
+	out.write( (const char*)dirs, numDirs * 3 * sizeof(GLfloat) );
+	out.write( (const char*)orders, (size_t)numDirs * numTets * sizeof(GLuint) );
+
+	if (out.fail()) return false;
+
+	out.close();
+
+	return true;
+
+}
+
+/// Size of order cache
+size_t orderCache::sizeOf(void) {
+
+	return ( ( (orders) ? (size_t)numDirs * numTets * sizeof(GLuint) : 0 ) + ///< Orders
+		 ( (dirs) ? numDirs * 3 * sizeof(GLfloat) : 0 ) + ///< Directions
+		 ( 2 * sizeof(GLuint) ) + ///< numTets, numDirs
+		 ( 2 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Nearest cached order
+GLuint orderCache::nearestOrder(GLuint *ids, const vec3& viewDir) const {
+
+	GLuint best = 0;
+	GLfloat bestDot = -1.0, len = viewDir.length();
+
+	/// Largest |cos| among the stored directions and their opposites
+	for (GLuint d = 0; d < numDirs; ++d) {
+
+		GLfloat dot = fabs( dirs[d*3] * viewDir[0] + dirs[d*3+1] * viewDir[1] + dirs[d*3+2] * viewDir[2] ) / len;
+
+		if( dot > bestDot ) { bestDot = dot; best = d; }
+
+	}
+
+	const GLuint *order = orders + (size_t)best * numTets;
+
+	bool opposite = ( dirs[best*3] * viewDir[0] + dirs[best*3+1] * viewDir[1] + dirs[best*3+2] * viewDir[2] ) < 0.0;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numTets; ++i)
+		ids[i] = ( opposite ) ? order[ numTets - 1 - i ] : order[i];
+
+	return best;
+
+}
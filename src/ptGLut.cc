@@ -63,6 +63,14 @@ static bool useBO = true; ///< Use buffer object flag
 static GLdouble drawTime = 0.0, sortTime = 0.0,
 	totalTime = 0.0; ///< Time spent in drawing
 
+static GLdouble stlSortTime = 0.0; ///< Last STL sort time (reference for the approximate sort)
+
+static bool measureErr = false; ///< Measure sort visibility error flag
+
+static bool pipelined = false; ///< Sort in a worker thread flag
+
+static bool softwareRender = false; ///< Draw with the CPU renderer flag
+
 static bool showHelp = false; ///< show help flag
 static bool showInfo = true; ///< show information flag
 
@@ -76,6 +84,15 @@ void glWriteBig(GLdouble x, GLdouble y, const char *str) {
 
 }
 
+/// Sort method name
+/// @arg _sT sort method
+/// @return name shown in the information box
+static const char* sortName(sortType _sT) {
+
+	return app.getSorterName(_sT);
+
+}
+
 /// glPT Show Information boxes
 
 void glPTShowInfo(void) {
@@ -96,7 +113,11 @@ void glPTShowInfo(void) {
 
 		char str[256];
 
-		sprintf(str, "Sort: %.5lf s ( %.1lf %% )", sortTime, 100*sortTime / totalTime );
+		if (pipelined) /// Sort time hidden behind the draw step
+			sprintf(str, "Sort: %.5lf s ( %.1lf %% overlapped with draw )", sortTime,
+				(sortTime > 0.0) ? 100*(drawTime + sortTime - totalTime) / sortTime : 0.0 );
+		else
+			sprintf(str, "Sort: %.5lf s ( %.1lf %% )", sortTime, 100*sortTime / totalTime );
 		glWrite(-1.1, 0.8, str);
 
 		sprintf(str, "Draw Step: %.5lf s ( %.1lf %% )", drawTime, 100*drawTime / totalTime );
@@ -108,6 +129,10 @@ void glPTShowInfo(void) {
 		sprintf(str, "# Tets / sec: %.2lf MTet/s ( %.1lf fps )", (app.volume.numTets / totalTime) / 1000000.0, 1.0 / totalTime );
 		glWrite(-1.1, 0.5, str);
 
+		sprintf(str, "Sort memory: %.1lf B/tet%s", app.sortSizeOf() / (GLdouble)app.volume.numTets,
+			app.compactSort() ? " (compact)" : "" );
+		glWrite(-1.1, -0.4, str);
+
 		sprintf(str, "# Tets: %d", app.volume.numTets );
 		glWrite(-1.1, -0.5, str);
 
@@ -117,11 +142,111 @@ void glPTShowInfo(void) {
 		sprintf(str, "Resolution: %d x %d", winWidth, winHeight );
 		glWrite(-1.1, -0.7, str);
 
-		sprintf(str, "Sort method: %s",
-			(currSort == none) ? "None" :
-			( (currSort == stl_sort) ? "STL Sort" :	
-			  ( (currSort == gpu_bitonic) ? "GPU Bitonic" :
-				( (currSort == gpu_quick) ? "GPU Quicksort" : "MPVO") ) ) );
+		/// Sort method state below is written by the worker thread while pipelined
+
+		if (currSort == cpu_bucket && !pipelined) { /// Approximate sort precision and error
+
+			sprintf(str, "Approx. sort: 2^%d buckets (width %.2e), %.2lf %% neighbours out of order",
+				app.getBucketBits(), app.getBucketWidth(), 100.0 * app.getBucketError() );
+			glWrite(-1.1, 0.4, str);
+
+			if (stlSortTime > 0.0) {
+				sprintf(str, "Approx. sort speed: %.1lfx STL sort", stlSortTime / sortTime );
+				glWrite(-1.1, 0.3, str);
+			}
+
+		}
+
+		sprintf(str, "Sort cache: %d hits, %.3lf s saved (tolerance %.1f deg)%s",
+			app.getSortCacheHits(), app.getSortSkippedTime(), app.getViewTolerance(),
+			app.lastSortWasSkipped() ? " - reused" : "" );
+		glWrite(-1.1, 0.2, str);
+
+		if (app.sortFirstOn()) { /// Tile lists of the sort-first mode (centroid order in each tile)
+
+			sprintf(str, "Sort-first: %d tiles of %d px, %.2lf tiles per tet", app.getScreenTiles().numTiles(),
+				app.getScreenTiles().getTileSize(), app.getScreenTiles().overlap() );
+			glWrite(-1.1, 0.1, str);
+
+		}
+
+		if (app.emptyCullingOn()) { /// Tets with opacity under the transfer function
+
+			sprintf(str, "Empty culling: %d of %d tets visible ( %.1lf %% ), %d drawn", app.getVisibleTets(),
+				app.volume.numTets, 100.0 * app.getVisibleTets() / app.volume.numTets, app.getDrawCount() );
+			glWrite(-1.1, 0.0, str);
+
+		}
+
+		if (currDraw == isos && app.isoIndexOn()) { /// Tets crossed by the iso-values (interval tree)
+
+			sprintf(str, "Active cells: %d of %d tets ( %.1lf %% ), %d drawn", app.getActiveTets(),
+				app.volume.numTets, 100.0 * app.getActiveTets() / app.volume.numTets, app.getDrawCount() );
+			glWrite(-1.1, -0.1, str);
+
+		}
+
+		if (app.frustumCullingOn() && !pipelined) { /// Tets in the view frustum (bounding volume hierarchy)
+
+			sprintf(str, "Frustum culling: %d of %d tets in view ( %.1lf %% ), %d of %d leaves culled", app.getTetsInView(),
+				app.volume.numTets, 100.0 * app.getTetsInView() / app.volume.numTets,
+				app.getFrustumCulling().culledLeaves(), app.getFrustumCulling().leaves() );
+			glWrite(-1.1, -0.2, str);
+
+		}
+
+		if (currSort == cpu_cached && !pipelined) { /// Cached direction used as starting order
+
+			sprintf(str, "Cached direction: %d of %d", app.getCachedDirection(), app.getCachedDirections() );
+			glWrite(-1.1, 0.4, str);
+
+		}
+
+		if ((currSort == cpu_incremental || currSort == cpu_cached) && !pipelined) { /// Order repaired or sorted from scratch
+
+			sprintf(str, "Incremental: %s", app.incrementalRepaired() ? "repair" : "full sort" );
+			glWrite(-1.1, 0.3, str);
+
+		}
+
+		if ((currSort == mpvo || currSort == mpvo_incremental) && !pipelined) { /// MPVO cycles found by the depth-first search
+
+			sprintf(str, "MPVO cycles: %d", app.getMPVOCycles() );
+			glWrite(-1.1, 0.4, str);
+
+		}
+
+		if (currSort == mpvo_incremental && !pipelined) { /// Faces revisited by the DAG update
+
+			sprintf(str, "DAG faces revisited: %d of %d", app.getDAGRevisited(), app.getDAGFaces() );
+			glWrite(-1.1, 0.3, str);
+
+		}
+
+		if (measureErr) { /// Visibility error of each measured sort method
+
+			glWrite(0.35, 0.8, "Sort error (area / faces):");
+
+			GLdouble y = 0.7;
+
+			for (int s = stl_sort; s < (int)app.getSorters().size(); ++s) {
+
+				if (app.getSortError((sortType)s) < 0.0) continue;
+
+				sprintf(str, "%s: %.3lf %% / %.3lf %%", sortName((sortType)s),
+					100.0 * app.getSortError((sortType)s), 100.0 * app.getSortErrorFaces((sortType)s) );
+				glWrite(0.35, y, str);
+				y -= 0.1;
+
+			}
+
+		}
+
+		if (app.getSorters().get(currSort) && !pipelined) /// Mean time of the sorter (all frames it sorted)
+			sprintf(str, "Sort method: %s (mean %.5lf s over %d sorts)", sortName(currSort),
+				app.getSorters().get(currSort)->meanTime(), app.getSorters().get(currSort)->numRuns() );
+		else
+			sprintf(str, "Sort method: %s", sortName(currSort) );
 
 		glWrite(-1.1, -0.8, str);
 
@@ -129,9 +254,13 @@ void glPTShowInfo(void) {
 			(useBO) ? "Buffer Objects" : "Sending from CPU" );
 		glWrite(-1.1, -0.9, str);
 
-		sprintf(str, "Render method: %s",
+		if (softwareRender) /// CPU renderer draws only DVR
+			sprintf(str, "Render method: DVR (CPU, %d triangles)", app.getSoftwareRenderer().numTriangles() );
+		else
+			sprintf(str, "Render method: %s%s",
 				(currDraw == dvr) ? "DVR" :
-				( (currDraw == isos) ? "Iso-surfaces" : "DVR + Iso-surfaces" ) );
+				( (currDraw == isos) ? "Iso-surfaces" : "DVR + Iso-surfaces" ),
+				(app.frontToBackOn()) ? " (front-to-back, early termination)" : "" );
 		glWrite(-1.1, -1.0, str);
 
 		if (!showHelp)
@@ -153,14 +282,38 @@ void glPTShowInfo(void) {
 		glWrite(-0.52,  0.1, "(i) open iso-surfaces window");
 		glWrite(-0.52,  0.0, "(d) draw volume on/off");
 		glWrite(-0.52, -0.1, "(0) no sort");
-		glWrite(-0.52, -0.2, "(1) use stl sort");
-		glWrite(-0.52, -0.3, "(2) use gpu bitonic sort");
-		glWrite(-0.52, -0.4, "(3) use gpu quick sort");
-		glWrite(-0.52, -0.5, "(4) use MPVO sort");
-		glWrite(-0.52, -0.6, "(7) draw DVR");
-		glWrite(-0.52, -0.7, "(8) draw ISO");
-		glWrite(-0.52, -0.8, "(9) draw DVR+ISO");
-		glWrite(-0.52, -0.9, "(q|esc) close application");
+		glWrite( 0.35,  0.7, "(y) view-frustum culling on/off");
+		glWrite( 0.35,  0.6, "(l) iso active-cell index on/off");
+		glWrite( 0.35,  0.5, "(x) cull empty tets (TF) on/off");
+		glWrite( 0.35,  0.4, "(u) front-to-back early termination on/off");
+		glWrite( 0.35,  0.3, "(f) sort-first screen tiles on/off");
+		glWrite( 0.35,  0.2, "(w) CPU software rendering on/off");
+		glWrite( 0.35,  0.1, "(p) pipelined sort on/off");
+		glWrite( 0.35,  0.0, "(v) view tolerance 0/0.5/1/2 deg");
+		glWrite( 0.35, -0.1, "([|]) approx. buckets -/+");
+		glWrite( 0.35, -0.2, "(e) measure sort error on/off");
+
+		/// Sorters with a key binding (built-in methods and plug-ins)
+		char str[256];
+		GLdouble x = -0.52, y = -0.2;
+
+		for (GLuint s = 0; s < app.getSorters().size(); ++s) {
+
+			const visibilitySorter *vs = app.getSorters().get(s);
+
+			if (!vs || !vs->key()) continue;
+
+			sprintf(str, "(%c) use %s", vs->key(), vs->name());
+			glWrite(x, y, str);
+
+			y -= 0.1;
+			if (x < 0.0 && y < -0.75) { x = 0.35; y = -0.3; } ///< Next column
+
+		}
+		glWrite(-0.52, -0.8, "(7) draw DVR");
+		glWrite(-0.52, -0.9, "(8) draw ISO");
+		glWrite(-0.52, -1.0, "(9) draw DVR+ISO");
+		glWrite(-0.52, -1.1, "(q|esc) close application");
 
 	}
 
@@ -210,10 +363,18 @@ void glPTDisplay(void) {
 	modelTrack.GetView();
 	modelTrack.Apply();
 
-	app.sort(st, currSort);
+	/// Sort method not registered (compact mode): first registered sorter
+	if( currSort != none && !app.getSorters().get(currSort) )
+		for (GLuint s = stl_sort; s < app.getSorters().size(); ++s)
+			if( app.getSorters().get(s) ) { currSort = (sortType)s; break; }
+
+	if( pipelined ) app.pipelineSort(st, currSort);
+	else app.sort(st, currSort);
 
-	if( drawVolume )
-	  app.draw(dt);
+	if( drawVolume ) {
+	  if( softwareRender ) app.softwareDraw(dt);
+	  else app.draw(dt);
+	}
 
 	glPTShowInfo();
 
@@ -225,8 +386,27 @@ void glPTDisplay(void) {
 	gettimeofday(&endtime, 0);
 	drawTime = dt + (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
 
+	if( pipelined ) { /// Upload is part of the draw step, sort runs in parallel
+
+		drawTime += st;
+
+		sortTime = app.getPipelineSortTime();
+
+		totalTime = ( drawTime > sortTime ) ? drawTime : sortTime;
+
+		/// Keep drawing until the last requested order is shown
+		if( app.pipelineBusy() && !alwaysRotating )
+			glutTimerFunc(8, glPTPipeline, 0);
+
+		return;
+
+	}
+
 	sortTime = st;
 
+	/// A reused order would make the STL reference time look free
+	if( currSort == stl_sort && !app.lastSortWasSkipped() ) stlSortTime = sortTime;
+
 	totalTime = drawTime + sortTime;
 	
 }
@@ -270,6 +450,20 @@ void glPTAnimate( int value ) {
 
 }
 
+/// glPT pipeline function
+
+void glPTPipeline( int value ) {
+
+	if( glutGetWindow() != 0 && glutGetWindow() != ptWinId ) {
+		int win = glutGetWindow();
+		glutSetWindow( ptWinId );
+		glutPostRedisplay();
+		glutSetWindow( win );
+	} else if( glutGetWindow() != 0 )
+		glutPostRedisplay();
+
+}
+
 /// glPT Keyboard
 
 void glPTKeyboard( unsigned char key, int x, int y ) {
@@ -278,17 +472,15 @@ void glPTKeyboard( unsigned char key, int x, int y ) {
 	case '0': // none
 	    currSort = none;
 	    break;
-	case '1': // stl_sort
-		currSort = stl_sort;
-		break;
-	case '2': // gpu_bitonic
-		currSort = gpu_bitonic;
+	case 'v': case 'V': // view tolerance to reuse the last order
+		app.setViewTolerance( (app.getViewTolerance() <= 0.0) ? 0.5 :
+				      ( (app.getViewTolerance() >= 2.0) ? 0.0 : 2.0 * app.getViewTolerance() ) );
 		break;
-	case '3': // gpu_quick
-	   currSort = gpu_quick;
+	case '[': // less approximate sort buckets
+		app.setBucketBits( app.getBucketBits() - 1 );
 		break;
-	case '4': // MPVO
-	    currSort = mpvo;
+	case ']': // more approximate sort buckets
+		app.setBucketBits( app.getBucketBits() + 1 );
 		break;
 	case '7': // Direct Volume Rendering
 	  currDraw = dvr;
@@ -303,6 +495,33 @@ void glPTKeyboard( unsigned char key, int x, int y ) {
 	  app.switchShaders(currDraw);
 	  break;
 
+	case 'p': case 'P': // pipelined sort flag (not with CUDA sorts)
+		if( ( pipelined || currSort == none || app.pipelineSorts(currSort) ) && app.usePipeline( !pipelined ) )
+			pipelined = !pipelined;
+		break;
+	case 'w': case 'W': // CPU software rendering flag (global order only)
+		softwareRender = !softwareRender;
+		if( softwareRender ) { app.useSortFirst( false ); app.useFrontToBack( false ); }
+		break;
+	case 'x': case 'X': // empty-tet culling (transfer function) flag
+		app.useEmptyCulling( !app.emptyCullingOn() );
+		break;
+	case 'y': case 'Y': // view-frustum culling (bounding volume hierarchy) flag
+		app.useFrustumCulling( !app.frustumCullingOn() );
+		break;
+	case 'l': case 'L': // iso-surface active-cell index (interval tree) flag
+		app.useIsoIndex( !app.isoIndexOn() );
+		break;
+	case 'u': case 'U': // front-to-back (under operator) with early termination flag
+		if( app.useFrontToBack( !app.frontToBackOn() ) && app.frontToBackOn() ) softwareRender = false;
+		break;
+	case 'f': case 'F': // sort-first (screen tiles) flag
+		if( app.useSortFirst( !app.sortFirstOn() ) && app.sortFirstOn() ) softwareRender = false;
+		break;
+	case 'e': case 'E': // measure sort error flag
+		measureErr = !measureErr;
+		app.measureSortError( measureErr );
+		break;
 	case 'd': case 'D':
 		drawVolume = !drawVolume;
 		break;
@@ -317,8 +536,8 @@ void glPTKeyboard( unsigned char key, int x, int y ) {
 		if (whiteBG) app.setColor(WHITE);
 		else app.setColor(BLACK);
 		break;
-	case 'o': case 'O': // change buffer object usage flag
-		useBO = !useBO;
+	case 'o': case 'O': // change buffer object usage flag (always used in compact mode)
+		useBO = !useBO || app.compactSort();
 		app.useBufferObject( useBO );
 		return;
 	case 'r': case 'R': // always rotating flag
@@ -348,7 +567,13 @@ void glPTKeyboard( unsigned char key, int x, int y ) {
 		glutDestroyWindow( isoWinId );
 		glutDestroyWindow( tfWinId );
 		return;
-	default: // any other key
+	default: // sorter key bindings (see the sorter registry) or any other key
+		if( app.getSorters().findKey(key) >= 0 ) {
+			currSort = (sortType)app.getSorters().findKey(key);
+			/// CUDA sorts run only in the OpenGL thread
+			if( pipelined && !app.pipelineSorts(currSort) && app.usePipeline(false) ) pipelined = false;
+			break;
+		}
 		cerr << "No key bind for " << key
 		     << " in (" << x << ", " << y << ")" << endl;
 		return;
@@ -489,7 +714,7 @@ void glPTSetup(void) {
 	lightTrack.center = vcg::Point3f(0, 0, 0);
 	lightTrack.radius = 1;
 	
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_ALPHA | GLUT_STENCIL); ///< Front-to-back opacity and mask
 	glutInitWindowSize(winWidth, winHeight);
 	glutInitWindowPosition(0, 0);
 	ptWinId = glutCreateWindow(titleWin);
@@ -0,0 +1,142 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   quantizedCentroids : defines a class to store the tetrahedra
+ *                        centroids quantized to 16 bits per coordinate
+ *                        inside the volume bounding box (compact sort).
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "quantizedCentroids.h"
+
+#include <cmath>
+
+/// ----------------------------------   quantizedCentroids   ------------------------------------
+
+/// Constructor
+quantizedCentroids::quantizedCentroids() :
+	numCentroids(0),
+	qX(NULL), qY(NULL), qZ(NULL) {
+
+	for (GLuint k = 0; k < 3; ++k) origin[k] = step[k] = 0.0;
+
+}
+
+/// Destructor
+quantizedCentroids::~quantizedCentroids() {
+
+	if( qX ) delete [] qX;
+	if( qY ) delete [] qY;
+	if( qZ ) delete [] qZ;
+
+}
+
+/// Build quantized centroids
+bool quantizedCentroids::build(const offVol< GLfloat, GLuint >& vol) {
+
+	numCentroids = vol.numTets;
+
+	if( qX ) delete [] qX;
+	qX = new GLushort[ numCentroids ];
+	if( !qX ) return false;
+
+	if( qY ) delete [] qY;
+	qY = new GLushort[ numCentroids ];
+	if( !qY ) return false;
+
+	if( qZ ) delete [] qZ;
+	qZ = new GLushort[ numCentroids ];
+	if( !qZ ) return false;
+
+	/// Bounding box of the vertices (contains all centroids)
+	GLfloat bbMin[3], bbMax[3];
+
+	for (GLuint k = 0; k < 3; ++k) bbMin[k] = bbMax[k] = vol.vertList[0][k];
+
+	for (GLuint v = 1; v < vol.numVerts; ++v) {
+		for (GLuint k = 0; k < 3; ++k) {
+			if( vol.vertList[v][k] < bbMin[k] ) bbMin[k] = vol.vertList[v][k];
+			if( vol.vertList[v][k] > bbMax[k] ) bbMax[k] = vol.vertList[v][k];
+		}
+	}
+
+	for (GLuint k = 0; k < 3; ++k) {
+		origin[k] = bbMin[k];
+		step[k] = ( bbMax[k] > bbMin[k] ) ? ( bbMax[k] - bbMin[k] ) / QUANT_LEVELS : 1.0;
+	}
+
+	GLushort *q[3] = { qX, qY, qZ };
+
+	/// Quantize the centroid of each tetrahedron (nearest level)
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numCentroids; ++i) {
+
+		appVol::vec3 c = ( vol.vertList[ vol.tetList[i][0] ].xyz()
+				   + vol.vertList[ vol.tetList[i][1] ].xyz()
+				   + vol.vertList[ vol.tetList[i][2] ].xyz()
+				   + vol.vertList[ vol.tetList[i][3] ].xyz() ) / 4.0;
+
+		for (GLuint k = 0; k < 3; ++k) {
+			GLint l = (GLint)floor( ( c[k] - origin[k] ) / step[k] + 0.5 );
+			q[k][i] = (GLushort)( (l < 0) ? 0 : ( (l > QUANT_LEVELS) ? QUANT_LEVELS : l ) );
+		}
+
+	}
+
+	return true;
+
+}
+
+/// Size of quantized centroids
+size_t quantizedCentroids::sizeOf(void) {
+
+	return ( ( (qX) ? (size_t)3 * numCentroids * sizeof(GLushort) : 0 ) + ///< Quantized centroids (SoA)
+		 ( 6 * sizeof(GLfloat) ) + ///< origin, step
+		 ( sizeof(GLuint) ) + ///< numCentroids
+		 ( 3 * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Packed depth keys
+void quantizedCentroids::packedKeys(uint_64 *p, const GLfloat *mv, GLuint row) const {
+
+	/// Depth of level (x, y, z): d0 + a[0] x + a[1] y + a[2] z
+	GLfloat a[3], d0 = mv[row+12], dMin, dMax;
+
+	for (GLuint k = 0; k < 3; ++k) {
+		a[k] = mv[row + 4*k] * step[k];
+		d0 += mv[row + 4*k] * origin[k];
+	}
+
+	/// Depth range over the bounding box corners
+	dMin = dMax = d0;
+
+	for (GLuint k = 0; k < 3; ++k) {
+		if( a[k] < 0.0 ) dMin += a[k] * QUANT_LEVELS;
+		else dMax += a[k] * QUANT_LEVELS;
+	}
+
+	GLfloat scale = ( dMax > dMin ) ? 4294967040.0 / ( dMax - dMin ) : 0.0; ///< largest float below 2^32
+
+	for (GLuint k = 0; k < 3; ++k) a[k] *= scale;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numCentroids; ++i) {
+
+		GLfloat d = a[0] * qX[i] + a[1] * qY[i] + a[2] * qZ[i] + (d0 - dMin) * scale;
+
+		uint_64 key = ( d > 0.0 ) ? ( ( d < 4294967040.0 ) ? (uint_64)d : 4294967040ULL ) : 0;
+
+		p[i] = ( key << 32 ) | (GLuint)i;
+
+	}
+
+}
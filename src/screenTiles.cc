@@ -0,0 +1,268 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   screenTiles : defines a class for sort-first visibility sorting,
+ *                 the tetrahedra are binned in screen tiles by their
+ *                 projected bounding box and each tile list is sorted
+ *                 on its own (in parallel).
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "screenTiles.h"
+
+#include <cmath>
+#include <algorithm>
+
+/// ----------------------------------   screenTiles   ------------------------------------
+
+/// Constructor
+screenTiles::screenTiles() :
+	tileSize(SORT_TILE),
+	tilesX(0), tilesY(0),
+	numTets(0),
+	winVerts(NULL), numWinVerts(0),
+	tileStart(NULL),
+	tileKeys(NULL), tileIds(NULL), tileListSize(0),
+	threadCount(NULL) {
+
+	for (GLuint k = 0; k < 4; ++k) view[k] = 0;
+
+}
+
+/// Destructor
+screenTiles::~screenTiles() {
+
+	if( winVerts ) delete [] winVerts;
+
+	if( tileStart ) delete [] tileStart;
+
+	if( tileKeys ) delete [] tileKeys;
+
+	if( tileIds ) delete [] tileIds;
+
+	if( threadCount ) delete [] threadCount;
+
+}
+
+/// Resize tiles
+bool screenTiles::resizeTiles(GLuint w, GLuint h) {
+
+	GLuint tX = (w + tileSize - 1) / tileSize, tY = (h + tileSize - 1) / tileSize;
+
+	if( tileStart && tX == tilesX && tY == tilesY ) return true;
+
+	tilesX = tX;
+	tilesY = tY;
+
+	if( tileStart ) delete [] tileStart;
+	tileStart = new GLuint[ tilesX * tilesY + 1 ];
+	if( !tileStart ) return false;
+
+	tileStart[0] = 0;
+
+	if( threadCount ) delete [] threadCount;
+	threadCount = new GLuint[ omp_get_max_threads() * tilesX * tilesY ];
+	if( !threadCount ) return false;
+
+	return true;
+
+}
+
+/// Tile rectangle
+void screenTiles::tileRect(GLuint t, GLint& x, GLint& y, GLsizei& w, GLsizei& h) const {
+
+	GLint tx = (t % tilesX) * tileSize, ty = (t / tilesX) * tileSize;
+
+	x = view[0] + tx;
+	y = view[1] + ty;
+	w = std::min( (GLint)tileSize, view[2] - tx );
+	h = std::min( (GLint)tileSize, view[3] - ty );
+
+}
+
+/// Tetrahedron tile bounds
+bool screenTiles::tetBounds(const offVol< GLfloat, GLuint >& vol, GLuint t, GLint& tx0, GLint& ty0, GLint& tx1, GLint& ty1) const {
+
+	GLfloat xMin, yMin, xMax, yMax;
+
+	xMin = xMax = winVerts[ vol.tetList[t][0]*2 + 0 ];
+	yMin = yMax = winVerts[ vol.tetList[t][0]*2 + 1 ];
+
+	if( xMin == (GLfloat)TILE_BEHIND ) { ///< Crosses the eye plane: all tiles
+		tx0 = ty0 = 0;
+		tx1 = tilesX - 1; ty1 = tilesY - 1;
+		return true;
+	}
+
+	for (GLuint j = 1; j < 4; ++j) {
+
+		GLfloat x = winVerts[ vol.tetList[t][j]*2 + 0 ], y = winVerts[ vol.tetList[t][j]*2 + 1 ];
+
+		if( x == (GLfloat)TILE_BEHIND ) {
+			tx0 = ty0 = 0;
+			tx1 = tilesX - 1; ty1 = tilesY - 1;
+			return true;
+		}
+
+		if( x < xMin ) xMin = x;
+		if( x > xMax ) xMax = x;
+		if( y < yMin ) yMin = y;
+		if( y > yMax ) yMax = y;
+
+	}
+
+	/// Outside the viewport: no fragment
+	if( xMax < 0.0 || yMax < 0.0 || xMin >= view[2] || yMin >= view[3] ) return false;
+
+	tx0 = std::max( (GLint)floor( xMin / tileSize ), 0 );
+	ty0 = std::max( (GLint)floor( yMin / tileSize ), 0 );
+	tx1 = std::min( (GLint)floor( xMax / tileSize ), (GLint)tilesX - 1 );
+	ty1 = std::min( (GLint)floor( yMax / tileSize ), (GLint)tilesY - 1 );
+
+	return true;
+
+}
+
+/// Bin and sort
+bool screenTiles::sort(const offVol< GLfloat, GLuint >& vol, const GLuint *keys,
+		       const GLfloat *mvp, const GLint *viewport, const GLubyte *visible) {
+
+	GLuint nV = vol.numVerts, nT = vol.numTets;
+
+	numTets = nT;
+
+	for (GLuint k = 0; k < 4; ++k) view[k] = viewport[k];
+
+	if( !resizeTiles( view[2], view[3] ) ) return false;
+
+	GLuint numTiles = tilesX * tilesY;
+
+	/// Window coordinates of the vertices (relative to the viewport)
+	if( numWinVerts < nV ) {
+		if( winVerts ) delete [] winVerts;
+		winVerts = new GLfloat[ nV * 2 ];
+		if( !winVerts ) { numWinVerts = 0; return false; }
+		numWinVerts = nV;
+	}
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)nV; ++i) {
+
+		GLfloat c[4];
+
+		for (GLuint r = 0; r < 4; ++r)
+			c[r] = mvp[r] * vol.vertList[i][0] + mvp[4 + r] * vol.vertList[i][1]
+				+ mvp[8 + r] * vol.vertList[i][2] + mvp[12 + r];
+
+		if( c[3] <= 0.0 ) {
+			winVerts[i*2 + 0] = winVerts[i*2 + 1] = TILE_BEHIND;
+			continue;
+		}
+
+		winVerts[i*2 + 0] = (c[0] / c[3] + 1.0) * 0.5 * view[2];
+		winVerts[i*2 + 1] = (c[1] / c[3] + 1.0) * 0.5 * view[3];
+
+	}
+
+	bool allocated = true;
+
+	/// Bin the tets in tiles: each thread counts and fills its
+	/// contiguous range of tets
+#pragma omp parallel
+	{
+
+		GLuint nt = omp_get_num_threads(), th = omp_get_thread_num();
+		GLuint begin = (GLuint)( (unsigned long long)nT * th / nt );
+		GLuint end = (GLuint)( (unsigned long long)nT * (th + 1) / nt );
+
+		GLuint *count = threadCount + th * numTiles;
+
+		memset( count, 0, numTiles * sizeof(GLuint) );
+
+		GLint tx0, ty0, tx1, ty1;
+
+		for (GLuint i = begin; i < end; ++i)
+			if( ( !visible || visible[i] ) && tetBounds( vol, i, tx0, ty0, tx1, ty1 ) )
+				for (GLint ty = ty0; ty <= ty1; ++ty)
+					for (GLint tx = tx0; tx <= tx1; ++tx)
+						++count[ ty * tilesX + tx ];
+
+#pragma omp barrier
+
+#pragma omp single
+		{
+
+			/// Tile lists: thread ranges in order inside each tile
+			GLuint sum = 0;
+
+			for (GLuint tile = 0; tile < numTiles; ++tile) {
+				tileStart[tile] = sum;
+				for (GLuint j = 0; j < nt; ++j) {
+					GLuint c = threadCount[ j * numTiles + tile ];
+					threadCount[ j * numTiles + tile ] = sum;
+					sum += c;
+				}
+			}
+
+			tileStart[numTiles] = sum;
+
+			if( sum > tileListSize ) {
+				if( tileKeys ) delete [] tileKeys;
+				if( tileIds ) delete [] tileIds;
+				tileListSize = sum + sum / 4;
+				tileKeys = new uint_64[ tileListSize ];
+				tileIds = new GLuint[ tileListSize ];
+				if( !tileKeys || !tileIds ) { allocated = false; tileListSize = 0; }
+			}
+
+		}
+
+		if( allocated )
+			for (GLuint i = begin; i < end; ++i)
+				if( ( !visible || visible[i] ) && tetBounds( vol, i, tx0, ty0, tx1, ty1 ) ) {
+					uint_64 key = ( (uint_64)keys[i] << 32 ) | i;
+					for (GLint ty = ty0; ty <= ty1; ++ty)
+						for (GLint tx = tx0; tx <= tx1; ++tx)
+							tileKeys[ count[ ty * tilesX + tx ]++ ] = key;
+				}
+
+	}
+
+	if( !allocated ) { tileStart[numTiles] = 0; return false; }
+
+	/// Sort each tile list on its own (ascending keys are back-to-front)
+#pragma omp parallel for schedule(dynamic, 1)
+	for (GLint tile = 0; tile < (GLint)numTiles; ++tile) {
+
+		uint_64 *first = tileKeys + tileStart[tile], *last = tileKeys + tileStart[tile + 1];
+
+		std::sort( first, last );
+
+		for (uint_64 *k = first; k < last; ++k)
+			tileIds[ k - tileKeys ] = (GLuint)*k;
+
+	}
+
+	return true;
+
+}
+
+/// Size of screen tiles
+size_t screenTiles::sizeOf(void) {
+
+	return ( ( (winVerts) ? numWinVerts * 2 * sizeof(GLfloat) : 0 ) + ///< Window coordinates
+		 ( (tileStart) ? (tilesX * tilesY + 1) * sizeof(GLuint) : 0 ) + ///< Tile list starts
+		 ( tileListSize * ( sizeof(uint_64) + sizeof(GLuint) ) ) + ///< Tile lists
+		 ( (threadCount) ? omp_get_max_threads() * tilesX * tilesY * sizeof(GLuint) : 0 ) + ///< Binning counts
+		 ( 10 * sizeof(GLuint) ) + ///< All GLuints
+		 ( 5 * sizeof(void*) ) ///< All pointers
+		);
+
+}
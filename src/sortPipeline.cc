@@ -0,0 +1,223 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   sortPipeline : defines a class to sort the tetrahedra in a worker
+ *                  thread, for the latest requested view, while the
+ *                  OpenGL thread draws with the last completed order.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "sortPipeline.h"
+
+#include <sys/time.h>
+
+#include <cstring>
+
+/// ----------------------------------   sortPipeline   ------------------------------------
+
+/// Constructor
+sortPipeline::sortPipeline() :
+	n(0), func(NULL), obj(NULL),
+	ready(-1), reading(-1),
+	pending(false), sorting(false), quit(false), started(false),
+	reqMethod(0), lastTime(0.0) {
+
+	for (GLuint s = 0; s < NUM_SORT_SLOTS; ++s) slots[s] = NULL;
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&cond, NULL);
+
+}
+
+/// Destructor
+sortPipeline::~sortPipeline() {
+
+	stop();
+
+	for (GLuint s = 0; s < NUM_SORT_SLOTS; ++s)
+		if( slots[s] ) delete [] slots[s];
+
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&mutex);
+
+}
+
+/// Start
+bool sortPipeline::start(GLuint _n, sortFunc _f, void *_obj) {
+
+	if( started ) return true;
+
+	if( n != _n ) {
+
+		for (GLuint s = 0; s < NUM_SORT_SLOTS; ++s) {
+			if( slots[s] ) delete [] slots[s];
+			slots[s] = new GLuint[_n];
+			if( !slots[s] ) return false;
+		}
+
+		n = _n;
+
+	}
+
+	func = _f;
+	obj = _obj;
+
+	ready = reading = -1;
+	pending = sorting = quit = false;
+
+	if( pthread_create(&thread, NULL, run, this) != 0 ) return false;
+
+	started = true;
+
+	return true;
+
+}
+
+/// Stop
+void sortPipeline::stop(void) {
+
+	if( !started ) return;
+
+	pthread_mutex_lock(&mutex);
+	quit = true;
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(thread, NULL);
+
+	started = false;
+
+}
+
+/// Request
+void sortPipeline::request(GLint method, const GLfloat *mv) {
+
+	pthread_mutex_lock(&mutex);
+
+	reqMethod = method;
+	memcpy(reqMV, mv, 16 * sizeof(GLfloat));
+	pending = true;
+
+	pthread_cond_signal(&cond);
+	pthread_mutex_unlock(&mutex);
+
+}
+
+/// Acquire
+const GLuint *sortPipeline::acquire(void) {
+
+	const GLuint *order = NULL;
+
+	pthread_mutex_lock(&mutex);
+
+	if( ready >= 0 && reading < 0 ) {
+		reading = ready;
+		ready = -1;
+		order = slots[reading];
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return order;
+
+}
+
+/// Release
+void sortPipeline::release(void) {
+
+	pthread_mutex_lock(&mutex);
+	reading = -1;
+	pthread_mutex_unlock(&mutex);
+
+}
+
+/// Busy
+bool sortPipeline::busy(void) {
+
+	pthread_mutex_lock(&mutex);
+	bool b = pending || sorting || ready >= 0;
+	pthread_mutex_unlock(&mutex);
+
+	return b;
+
+}
+
+/// Last sort time
+GLdouble sortPipeline::sortTime(void) {
+
+	pthread_mutex_lock(&mutex);
+	GLdouble t = lastTime;
+	pthread_mutex_unlock(&mutex);
+
+	return t;
+
+}
+
+/// Size of sort pipeline
+size_t sortPipeline::sizeOf(void) {
+
+	return ( ( (slots[0]) ? (size_t)NUM_SORT_SLOTS * n * sizeof(GLuint) : 0 ) + ///< Order slots
+		 ( 16 * sizeof(GLfloat) ) + ///< Requested modelview
+		 ( 4 * sizeof(GLint) ) + ///< n, ready, reading, reqMethod
+		 ( 4 * sizeof(bool) ) + ///< Worker state
+		 ( sizeof(GLdouble) ) + ///< lastTime
+		 ( (NUM_SORT_SLOTS + 2) * sizeof(void*) ) ///< All pointers
+		);
+
+}
+
+/// Worker thread loop
+void *sortPipeline::run(void *_p) {
+
+	sortPipeline *p = (sortPipeline*)_p;
+
+	GLfloat mv[16];
+	struct timeval starttime, endtime;
+
+	pthread_mutex_lock(&p->mutex);
+
+	while( true ) {
+
+		while( !p->pending && !p->quit )
+			pthread_cond_wait(&p->cond, &p->mutex);
+
+		if( p->quit ) break;
+
+		/// Take the latest request and a slot neither completed nor being read
+		GLint method = p->reqMethod;
+		memcpy(mv, p->reqMV, 16 * sizeof(GLfloat));
+		p->pending = false;
+		p->sorting = true;
+
+		GLint w = 0;
+		while( w == p->ready || w == p->reading ) ++w;
+
+		pthread_mutex_unlock(&p->mutex);
+
+		gettimeofday(&starttime, 0);
+
+		p->func(p->obj, method, mv, p->slots[w]);
+
+		gettimeofday(&endtime, 0);
+
+		pthread_mutex_lock(&p->mutex);
+
+		/// The new order replaces a completed one not yet read
+		p->ready = w;
+		p->sorting = false;
+		p->lastTime = (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
+
+	}
+
+	pthread_mutex_unlock(&p->mutex);
+
+	return NULL;
+
+}
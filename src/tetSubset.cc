@@ -0,0 +1,127 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   tetSubset : defines a class to keep a subset of the tetrahedra, as a
+ *               list of ids and one flag per tetrahedron, shared by the
+ *               indexes that restrict the tetrahedra sorted and drawn.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "tetSubset.h"
+
+/// ----------------------------------   tetSubset   ------------------------------------
+
+/// Constructor
+tetSubset::tetSubset() :
+	numTets(0),
+	flag(NULL),
+	ids(NULL), count(0),
+	filterIds(NULL),
+	threadCount(NULL) {
+
+}
+
+/// Destructor
+tetSubset::~tetSubset() {
+
+	if( flag ) delete [] flag;
+
+	if( ids ) delete [] ids;
+
+	if( filterIds ) delete [] filterIds;
+
+	if( threadCount ) delete [] threadCount;
+
+}
+
+/// Create subset
+bool tetSubset::create(GLuint _numTets) {
+
+	numTets = _numTets;
+	count = 0;
+
+	if( flag ) delete [] flag;
+	flag = new GLubyte[ numTets ];
+	if( !flag ) return false;
+
+	memset( flag, 0, numTets * sizeof(GLubyte) );
+
+	if( ids ) delete [] ids;
+	ids = new GLuint[ numTets ];
+	if( !ids ) return false;
+
+	if( filterIds ) delete [] filterIds;
+	filterIds = NULL;
+
+	if( threadCount ) delete [] threadCount;
+	threadCount = new GLuint[ omp_get_max_threads() ];
+	if( !threadCount ) return false;
+
+	return true;
+
+}
+
+/// Fill subset
+void tetSubset::fill(void) {
+
+	memset( flag, 1, numTets * sizeof(GLubyte) );
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numTets; ++i)
+		ids[i] = i;
+
+	count = numTets;
+
+}
+
+/// Clear subset
+void tetSubset::clear(void) {
+
+#pragma omp parallel for
+	for (GLint k = 0; k < (GLint)count; ++k)
+		flag[ ids[k] ] = 0;
+
+	count = 0;
+
+}
+
+/// Compact flags
+void tetSubset::compact(void) {
+
+	count = cpuSort::compact( ids, NULL, numTets, flag, threadCount );
+
+}
+
+/// Filter an order
+GLuint tetSubset::filter(GLuint *order, GLuint n) {
+
+	if( !filterIds ) filterIds = new GLuint[ numTets ];
+	if( !filterIds ) return n;
+
+	GLuint kept = cpuSort::compact( filterIds, order, n, flag, threadCount );
+
+	memcpy( order, filterIds, kept * sizeof(GLuint) );
+
+	return kept;
+
+}
+
+/// Size of subset data
+size_t tetSubset::sizeOf(void) {
+
+	return ( ( (flag) ? numTets * sizeof(GLubyte) : 0 ) + ///< Flags
+		 ( (ids) ? numTets * sizeof(GLuint) : 0 ) + ///< List
+		 ( (filterIds) ? numTets * sizeof(GLuint) : 0 ) + ///< Filter output
+		 ( (threadCount) ? omp_get_max_threads() * sizeof(GLuint) : 0 ) + ///< Compaction counts
+		 ( 2 * sizeof(GLuint) ) + ///< numTets, count
+		 ( 4 * sizeof(void*) ) ///< All pointers
+		);
+
+}
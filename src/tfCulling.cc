@@ -0,0 +1,133 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   tfCulling : defines a class to cull the tetrahedra with no opacity
+ *               under the transfer function, keeping a compact list of
+ *               the visible tetrahedra to be sorted and drawn.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "tfCulling.h"
+
+#include <cmath>
+
+/// ----------------------------------   tfCulling   ------------------------------------
+
+/// Constructor
+tfCulling::tfCulling() :
+	numTets(0),
+	range(NULL),
+	opacityPrefix(NULL), numColors(0) {
+
+}
+
+/// Destructor
+tfCulling::~tfCulling() {
+
+	if( range ) delete [] range;
+
+	if( opacityPrefix ) delete [] opacityPrefix;
+
+}
+
+/// Build scalar ranges
+bool tfCulling::build(const offVol< GLfloat, GLuint >& vol) {
+
+	numTets = vol.numTets;
+
+	if( range ) delete [] range;
+	range = new GLushort[ 2 * numTets ];
+	if( !range ) return false;
+
+	if( !visible.create( numTets ) ) return false;
+
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numTets; ++i) {
+
+		GLfloat sMin = vol.vertList[ vol.tetList[i][0] ][3], sMax = sMin;
+
+		for (GLuint j = 1; j < 4; ++j) {
+			GLfloat s = vol.vertList[ vol.tetList[i][j] ][3];
+			if( s < sMin ) sMin = s;
+			if( s > sMax ) sMax = s;
+		}
+
+		/// Scalars in [0, 1], minimum rounded down and maximum up
+		GLint lo = (GLint)floor( sMin * CULL_LEVELS ), hi = (GLint)ceil( sMax * CULL_LEVELS );
+
+		range[i*2 + 0] = (GLushort)( (lo < 0) ? 0 : ( (lo > CULL_LEVELS) ? CULL_LEVELS : lo ) );
+		range[i*2 + 1] = (GLushort)( (hi < 0) ? 0 : ( (hi > CULL_LEVELS) ? CULL_LEVELS : hi ) );
+
+	}
+
+	/// Everything visible until the first update
+	visible.fill();
+
+	return true;
+
+}
+
+/// Update visible list
+bool tfCulling::update(const offVol< GLfloat, GLuint >& vol) {
+
+	if( !range ) return false;
+
+	if( !opacityPrefix || numColors != vol.numColors ) {
+		numColors = vol.numColors;
+		if( opacityPrefix ) delete [] opacityPrefix;
+		opacityPrefix = new GLuint[ numColors + 1 ];
+		if( !opacityPrefix ) return false;
+	}
+
+	/// Prefix count of the entries with opacity (as sampled by
+	/// hapt_dvr.frag, nearest entry of each scalar)
+	opacityPrefix[0] = 0;
+
+	for (GLuint c = 0; c < numColors; ++c)
+		opacityPrefix[c + 1] = opacityPrefix[c] + ( ( vol.tf[c][3] > 0.0 ) ? 1 : 0 );
+
+	const GLuint *prefix = opacityPrefix;
+	const GLuint nC = numColors;
+
+	GLubyte *visibleFlag = visible.flags();
+
+	/// Flag the tets with any entry of their range opaque
+#pragma omp parallel for
+	for (GLint i = 0; i < (GLint)numTets; ++i) {
+
+		/// Entries of the range ends (scalar * numColors, clamped)
+		GLuint lo = ( range[i*2 + 0] * nC ) / CULL_LEVELS;
+		GLuint hi = ( range[i*2 + 1] * nC ) / CULL_LEVELS;
+
+		if( lo >= nC ) lo = nC - 1;
+		if( hi >= nC ) hi = nC - 1;
+
+		visibleFlag[i] = ( prefix[hi + 1] != prefix[lo] );
+
+	}
+
+	/// Compact the visible tets in parallel (ascending ids)
+	visible.compact();
+
+	return true;
+
+}
+
+/// Size of culling data
+size_t tfCulling::sizeOf(void) {
+
+	return ( ( (range) ? (size_t)2 * numTets * sizeof(GLushort) : 0 ) + ///< Scalar ranges
+		 ( (opacityPrefix) ? (numColors + 1) * sizeof(GLuint) : 0 ) + ///< Opacity prefix table
+		 ( visible.sizeOf() ) + ///< Visible tets
+		 ( 2 * sizeof(GLuint) ) + ///< All GLuints
+		 ( 2 * sizeof(void*) ) ///< All pointers
+		);
+
+}
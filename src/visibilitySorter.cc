@@ -0,0 +1,192 @@
+/**
+ *   HAPT -- Hardware-Assisted Projected Tetrahedra
+ *
+ */
+
+/**
+ *   visibilitySorter : defines the interface of the visibility sorters
+ *                      (back-to-front ordering of the tetrahedra) and
+ *                      the registry listing them for the renderer, the
+ *                      key bindings and the information overlay.
+ *
+ * C++ implementation.
+ *
+ */
+
+/// --------------------------------   Definitions   ------------------------------------
+
+#include "visibilitySorter.h"
+
+#include <sys/time.h>
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+/// ----------------------------------   visibilitySorter   ------------------------------------
+
+/// Constructor
+visibilitySorter::visibilitySorter(const char *_name, char _key) :
+	sorterName(_name), sorterKey(_key),
+	last(0.0), total(0.0), runs(0) {
+
+}
+
+/// Destructor
+visibilitySorter::~visibilitySorter() {
+
+}
+
+/// Timed sort
+void visibilitySorter::run(GLuint *ids, const GLfloat *mv) {
+
+	struct timeval starttime, endtime;
+	gettimeofday(&starttime, 0);
+
+	sort(ids, mv);
+
+	gettimeofday(&endtime, 0);
+	last = (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)/1000000.0;
+
+	total += last;
+	++runs;
+
+}
+
+/// ----------------------------------   sorterRegistry   ------------------------------------
+
+sorterRegistry::sorterFactory sorterRegistry::plugins[MAX_SORTERS];
+
+GLuint sorterRegistry::numPlugins = 0;
+
+/// Constructor
+sorterRegistry::sorterRegistry() : count(0) {
+
+	for (GLuint i = 0; i < MAX_SORTERS; ++i) sorters[i] = NULL;
+
+}
+
+/// Destructor
+sorterRegistry::~sorterRegistry() {
+
+	clear();
+
+}
+
+/// Add sorter
+GLint sorterRegistry::add(visibilitySorter *s, GLint id) {
+
+	if( !s ) return -1;
+
+	if( id < 0 ) id = count;
+
+	if( id >= MAX_SORTERS || sorters[id] ) {
+		cerr << "No sorter id left for " << s->name() << endl;
+		delete s;
+		return -1;
+	}
+
+	sorters[id] = s;
+
+	if( id >= (GLint)count ) count = id + 1;
+
+	return id;
+
+}
+
+/// Add plug-ins
+GLuint sorterRegistry::addPlugins(void) {
+
+	GLuint added = 0;
+
+	for (GLuint p = 0; p < numPlugins; ++p)
+		if( add( plugins[p]() ) >= 0 ) ++added;
+
+	return added;
+
+}
+
+/// Initialize sorters
+GLuint sorterRegistry::init(const offVol< GLfloat, GLuint >& vol, const centroidStore& c) {
+
+	GLuint n = 0;
+
+	for (GLuint i = 0; i < count; ++i) {
+
+		if( !sorters[i] ) continue;
+
+		if( sorters[i]->init(vol, c) ) { ++n; continue; }
+
+		cerr << "Sorter " << sorters[i]->name() << " could not be initialized" << endl;
+
+		delete sorters[i];
+		sorters[i] = NULL;
+
+	}
+
+	return n;
+
+}
+
+/// Clear
+void sorterRegistry::clear(void) {
+
+	for (GLuint i = 0; i < count; ++i) {
+		if( sorters[i] ) delete sorters[i];
+		sorters[i] = NULL;
+	}
+
+	count = 0;
+
+}
+
+/// Find key
+GLint sorterRegistry::findKey(char k) const {
+
+	if( !k ) return -1;
+
+	for (GLuint i = 0; i < count; ++i)
+		if( sorters[i] && tolower( sorters[i]->key() ) == tolower(k) )
+			return i;
+
+	return -1;
+
+}
+
+/// Find name
+GLint sorterRegistry::findName(const char *n) const {
+
+	for (GLuint i = 0; i < count; ++i)
+		if( sorters[i] && strcmp( sorters[i]->name(), n ) == 0 )
+			return i;
+
+	return -1;
+
+}
+
+/// Size of sorter registry
+size_t sorterRegistry::sizeOf(GLuint first) {
+
+	size_t sz = ( MAX_SORTERS * sizeof(void*) ) + ///< Sorters
+		 ( sizeof(GLuint) ); ///< count
+
+	for (GLuint i = first; i < count; ++i)
+		if( sorters[i] ) sz += sorters[i]->sizeOf();
+
+	return sz;
+
+}
+
+/// Register plug-in
+bool sorterRegistry::registerPlugin(sorterFactory f) {
+
+	if( numPlugins >= MAX_SORTERS ) return false;
+
+	plugins[numPlugins++] = f;
+
+	return true;
+
+}